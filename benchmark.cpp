@@ -0,0 +1,712 @@
+#include "cppargparser.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+using namespace argparse;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Stops the optimiser from throwing away the looked up values
+volatile uint32_t gSink;
+
+/// Heap use, counted by the global operator new and delete below
+std::atomic<size_t> gAllocations(0);
+std::atomic<size_t> gLiveBytes(0);
+std::atomic<size_t> gPeakBytes(0);
+
+/// Room before each block for its size, keeping the block's alignment
+const size_t HeaderSize = 16;
+
+void* CountedAlloc(size_t size) {
+    char* block = (char*)malloc(size + HeaderSize);
+    if(block == NULL) {
+        throw std::bad_alloc();
+    }
+    memcpy(block, &size, sizeof(size));
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    size_t live = gLiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = gPeakBytes.load(std::memory_order_relaxed);
+    while(live > peak && !gPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return block + HeaderSize;
+}
+
+void CountedFree(void* ptr) {
+    if(ptr == NULL) {
+        return;
+    }
+    char* block = (char*)ptr - HeaderSize;
+    size_t size;
+    memcpy(&size, block, sizeof(size));
+    gLiveBytes.fetch_sub(size, std::memory_order_relaxed);
+    free(block);
+}
+
+}
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { CountedFree(ptr); }
+
+namespace {
+
+/**
+ * @brief One case of a benchmark, and what it measured. Printed as a CSV row.
+ * Parameters that don't apply to a benchmark are 0
+ */
+struct Measurement {
+    const char* mBenchmark = "";
+    size_t mOptions = 0;        ///< Arguments in the schema
+    size_t mTokens = 0;         ///< Tokens in argv, or elements in a list
+    const char* mForm = "-";    ///< How values are given: "split" (--key value) or "joined" (--key=value)
+    size_t mValueLength = 0;
+    size_t mFlagPercent = 0;    ///< Of the arguments, how many are flags
+    size_t mErrorPercent = 0;   ///< Of the command lines, how many fail to parse
+    size_t mThreads = 1;
+    double mNsPerOp = 0;
+    double mAllocsPerOp = 0;
+    size_t mPeakBytes = 0;      ///< Most heap in use at once while measuring, above what was in use before
+    double mP99Ns = 0;          ///< 99th percentile of an operation, for benchmarks that time each one
+};
+
+/// Benchmarks whose names don't start with this are skipped
+String gFilter;
+/// Measure each case for at least this long
+double gMinSeconds = 0.05;
+
+void PrintHeader() {
+    std::cout << "benchmark,options,tokens,form,value_length,flag_percent,error_percent,threads,"
+                 "ns_per_op,allocs_per_op,peak_bytes,p99_ns" << std::endl;
+}
+
+void Print(const Measurement &m) {
+    std::cout << m.mBenchmark << "," << m.mOptions << "," << m.mTokens << "," << m.mForm << ","
+              << m.mValueLength << "," << m.mFlagPercent << "," << m.mErrorPercent << "," << m.mThreads << ","
+              << m.mNsPerOp << "," << m.mAllocsPerOp << "," << m.mPeakBytes << "," << m.mP99Ns << std::endl;
+}
+
+bool Enabled(const char* pBenchmark) {
+    return StringView(pBenchmark).substr(0, gFilter.length()) == gFilter;
+}
+
+/**
+ * @brief Time pOp, running it in doubling batches until gMinSeconds have passed, then print the measurements
+ * @param pOp Runs the operation once
+ */
+template<typename Op>
+void Measure(Measurement &m, Op pOp) {
+    pOp(); // Warm up, so one-off allocations aren't counted
+    size_t ops = 0, batch = 1;
+    size_t allocations = gAllocations.load();
+    size_t baseBytes = gLiveBytes.load();
+    gPeakBytes.store(baseBytes);
+    Clock::time_point start = Clock::now();
+    double seconds = 0;
+    while(seconds < gMinSeconds) {
+        for(size_t i = 0; i < batch; i++) {
+            pOp();
+        }
+        ops += batch;
+        batch *= 2;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    m.mNsPerOp = seconds * 1e9 / ops;
+    m.mAllocsPerOp = (double)(gAllocations.load() - allocations) / ops;
+    m.mPeakBytes = gPeakBytes.load() - baseBytes;
+    Print(m);
+}
+
+/// Builds 'count' option names, e.g. --option-12, each with an alias, e.g. -o12
+Vector<String> MakeNames(size_t count) {
+    Vector<String> names;
+    for(size_t i = 0; i < count; i++) {
+        names.push_back("--option-" + std::to_string(i));
+        names.push_back("-o" + std::to_string(i));
+    }
+    return names;
+}
+
+double NsPerOp(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+/// @brief A command line to parse, owning the strings argv points to
+struct CommandLine {
+    Vector<String> mTokens;
+    Vector<const char*> mArgv;
+
+    void finish() {
+        this->mArgv.clear();
+        for(const String &token : this->mTokens) {
+            this->mArgv.push_back(token.c_str());
+        }
+    }
+};
+
+/// @brief True if argument i is a flag in a parser made by AddOptions. Spread evenly
+bool IsFlag(size_t i, size_t pFlagPercent) {
+    return (i * 37) % 100 < pFlagPercent;
+}
+
+/**
+ * @brief Give the parser pOptions arguments, pFlagPercent of them flags, and finalize it.
+ * Argument i is '--option-i', alias '-oi'. Errors are returned rather than thrown or printed
+ */
+void AddOptions(ArgParser &pParser, size_t pOptions, size_t pFlagPercent) {
+    Vector<String> names = MakeNames(pOptions);
+    for(size_t i = 0; i < pOptions; i++) {
+        if(IsFlag(i, pFlagPercent)) {
+            pParser.addFlag(names[i * 2], names[i * 2 + 1], "A flag");
+        } else {
+            pParser.addArg(names[i * 2], names[i * 2 + 1], "An option with a longer description, to fill out the help text");
+        }
+    }
+    pParser.setCatchExceptions(true);
+    pParser.setPrintHelpOnCaughtException(false);
+    pParser.finalize();
+}
+
+/**
+ * @brief Parse cost over schema size, argv length, value form and length, flag density and error rate
+ */
+void BenchParse() {
+    if(!Enabled("parse")) return;
+    const size_t optionCounts[] = { 10, 100, 1000 };
+    const size_t tokenCounts[] = { 8, 64, 512 };
+    const size_t valueLengths[] = { 4, 64 };
+    const size_t flagPercents[] = { 0, 50 };
+    const size_t errorPercents[] = { 0, 10 };
+    for(size_t options : optionCounts)
+    for(size_t flagPercent : flagPercents) {
+        ArgParser parser;
+        AddOptions(parser, options, flagPercent);
+        for(size_t tokens : tokenCounts)
+        for(int joined = 0; joined < 2; joined++)
+        for(size_t valueLength : valueLengths)
+        for(size_t errorPercent : errorPercents) {
+            // Ten command lines, parsed in turn. errorPercent of them have an unknown argument half way
+            Vector<CommandLine> lines(10);
+            for(size_t l = 0; l < lines.size(); l++) {
+                CommandLine &line = lines[l];
+                line.mTokens.push_back("program");
+                bool isBad = l * 100 / lines.size() < errorPercent;
+                for(size_t i = 0; line.mTokens.size() < tokens; i++) {
+                    size_t option = (i * 7919 + l) % options;
+                    String name = "--option-" + std::to_string(option);
+                    if(isBad && line.mTokens.size() >= tokens / 2) {
+                        line.mTokens.push_back("--unknown");
+                        isBad = false;
+                    } else if(IsFlag(option, flagPercent)) {
+                        line.mTokens.push_back(name);
+                    } else if(joined) {
+                        line.mTokens.push_back(name + "=" + String(valueLength, 'v'));
+                    } else {
+                        line.mTokens.push_back(name);
+                        line.mTokens.push_back(String(valueLength, 'v'));
+                    }
+                }
+                line.finish();
+            }
+            Measurement m;
+            m.mBenchmark = "parse";
+            m.mOptions = options;
+            m.mTokens = tokens;
+            m.mForm = joined ? "joined" : "split";
+            m.mValueLength = valueLength;
+            m.mFlagPercent = flagPercent;
+            m.mErrorPercent = errorPercent;
+            size_t next = 0;
+            Measure(m, [&]() {
+                CommandLine &line = lines[next++ % lines.size()];
+                gSink = parser.parse((int)line.mArgv.size(), line.mArgv.data());
+            });
+        }
+    }
+}
+
+/**
+ * @brief Lookup cost for an option name as the schema grows: std::map, ArgIndex, and the parser's operator[]
+ */
+void BenchLookup() {
+    if(!Enabled("lookup")) return;
+    for(size_t count = 10; count <= 10000; count *= 10) {
+        Vector<String> names = MakeNames(count);
+        // Spread the lookups over the keys in a cache-unfriendly order
+        Vector<StringView> queries;
+        for(size_t i = 0; i < 4096; i++) {
+            queries.push_back(names[(i * 2654435761u) % names.size()]);
+        }
+
+        Map<String, uint32_t> map;
+        ArgIndex index;
+        index.reset(names.size());
+        for(size_t i = 0; i < names.size(); i++) {
+            map.insert(std::make_pair(names[i], (uint32_t)i));
+            index.insert(names[i], (uint32_t)i);
+        }
+
+        ArgParser parser;
+        AddOptions(parser, count, 0);
+        const char* argv[] = { "program" };
+        parser.parse(1, argv);
+
+        Measurement m;
+        m.mOptions = count;
+        size_t next = 0;
+        m.mBenchmark = "lookup_map";
+        Measure(m, [&]() {
+            StringView query = queries[next++ & 4095];
+            gSink = map.find(String(query.data(), query.length()))->second;
+        });
+        m.mBenchmark = "lookup_index";
+        Measure(m, [&]() {
+            gSink = index.find(queries[next++ & 4095]);
+        });
+        m.mBenchmark = "lookup_operator";
+        Measure(m, [&]() {
+            gSink = (uint32_t)parser[queries[next++ & 4095].data()].mValue.length();
+        });
+    }
+}
+
+/**
+ * @brief The as* conversions, of a value already parsed
+ */
+void BenchConvert() {
+    if(!Enabled("convert")) return;
+    ArgPair number, real, size, flag;
+    number.mValue = "123456";
+    real.mValue = "3.14159";
+    size.mValue = "64M";
+    flag.mValue = "true";
+
+    Measurement m;
+    m.mBenchmark = "convert_asInt";
+    Measure(m, [&]() { gSink = (uint32_t)number.asInt(); });
+    m.mBenchmark = "convert_asDouble";
+    Measure(m, [&]() { gSink = (uint32_t)real.asDouble(); });
+    m.mBenchmark = "convert_asSize";
+    Measure(m, [&]() { gSink = (uint32_t)size.asSize(); });
+    m.mBenchmark = "convert_asBool";
+    Measure(m, [&]() { gSink = flag.asBool(); });
+    m.mBenchmark = "convert_asString";
+    Measure(m, [&]() { gSink = (uint32_t)number.asString().length(); });
+}
+
+/**
+ * @brief Converting a comma-separated list of ints: splitting into strings and stoi versus asIntList
+ */
+void BenchList() {
+    if(!Enabled("list")) return;
+    for(size_t elements = 1000; elements <= 100000; elements *= 10) {
+        String list;
+        for(size_t i = 0; i < elements; i++) {
+            if(i > 0) list += ',';
+            list += std::to_string((i * 2654435761u) % 1000000);
+        }
+        ArgPair pair;
+        pair.mValue = list;
+
+        Measurement m;
+        m.mTokens = elements;
+        m.mBenchmark = "list_split_stoi";
+        Measure(m, [&]() {
+            std::vector<int> values;
+            size_t from = 0;
+            while(from <= list.size()) {
+                size_t to = list.find(',', from);
+                if(to == String::npos) to = list.size();
+                values.push_back(std::stoi(list.substr(from, to - from)));
+                from = to + 1;
+            }
+            gSink = (uint32_t)values.back();
+        });
+        m.mBenchmark = "list_asIntList";
+        Measure(m, [&]() {
+            gSink = (uint32_t)pair.asIntList().back();
+        });
+    }
+}
+
+/**
+ * @brief Building the perfect hash of an argument's choices, and checking a value against it, as the choices grow
+ */
+void BenchChoices() {
+    if(!Enabled("choices")) return;
+    for(size_t count = 10; count <= 10000; count *= 10) {
+        String choices;
+        for(size_t i = 0; i < count; i++) {
+            if(i > 0) choices += ',';
+            choices += "choice-" + std::to_string(i);
+        }
+        Vector<String> values;
+        for(size_t i = 0; i < 4096; i++) {
+            values.push_back("choice-" + std::to_string((i * 2654435761u) % count));
+        }
+        Measurement m;
+        m.mTokens = count;
+        m.mBenchmark = "choices_build";
+        Measure(m, [&]() {
+            detail::ChoiceSet set;
+            set.build(choices);
+            gSink = (uint32_t)set.bytes();
+        });
+        detail::ChoiceSet set;
+        set.build(choices);
+        size_t next = 0;
+        m.mBenchmark = "choices_find";
+        Measure(m, [&]() { gSink = (uint32_t)set.find(values[next++ & 4095]); });
+    }
+}
+
+/**
+ * @brief Getting the help text and example command as the schema grows. Both are rendered once and
+ * then copied, so help_render measures rendering itself, by changing the width each time
+ */
+void BenchHelp() {
+    if(!Enabled("help")) return;
+    for(size_t count = 10; count <= 1000; count *= 10) {
+        ArgParser parser;
+        AddOptions(parser, count, 20);
+        Measurement m;
+        m.mOptions = count;
+        m.mFlagPercent = 20;
+        m.mBenchmark = "help_getHelp";
+        Measure(m, [&]() { gSink = (uint32_t)parser.getHelp().length(); });
+        m.mBenchmark = "help_getExampleCommand";
+        Measure(m, [&]() { gSink = (uint32_t)parser.getExampleCommand().length(); });
+        m.mBenchmark = "help_render";
+        size_t width = 80;
+        Measure(m, [&]() {
+            width = width == 80 ? 81 : 80;
+            parser.setHelpWidth(width);
+            gSink = (uint32_t)parser.getHelp().length();
+        });
+    }
+}
+
+/**
+ * @brief Completing an option name as the schema grows. Completion scans the names rather than indexing them.
+ * complete_name times complete() on a finalized parser. complete_request times what a TAB press costs
+ * the program: adding the arguments to a new parser, then parsing '--__complete', which prints the
+ * candidates (to /dev/null here) without finalizing
+ */
+void BenchComplete() {
+    if(!Enabled("complete")) return;
+    for(size_t count = 10; count <= 10000; count *= 10) {
+        ArgParser parser;
+        AddOptions(parser, count, 20);
+        parser.setCompletion(true);
+        StringView words[] = { "program", "--option-0", "value", "--option-1" };
+        Vector<StringView> candidates;
+        Measurement m;
+        m.mBenchmark = "complete_name";
+        m.mOptions = count;
+        m.mTokens = 4;
+        m.mFlagPercent = 20;
+        Measure(m, [&]() {
+            candidates.clear();
+            parser.complete(words, 4, 3, candidates);
+            gSink = (uint32_t)candidates.size();
+        });
+
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        Vector<String> names = MakeNames(count);
+        const char* argv[] = { "program", "--__complete", "3", "program", "--option-0", "value", "--option-1" };
+        Vector<double> times;
+        size_t allocations = gAllocations.load();
+        size_t baseBytes = gLiveBytes.load();
+        gPeakBytes.store(baseBytes);
+        std::cout.flush();
+        int savedStdout = dup(1);
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, 1);
+        Clock::time_point start = Clock::now();
+        do {
+            Clock::time_point opStart = Clock::now();
+            ArgParser request;
+            for(size_t i = 0; i < count; i++) {
+                if(IsFlag(i, 20)) {
+                    request.addFlag(names[i * 2], names[i * 2 + 1], "A flag");
+                } else {
+                    request.addArg(names[i * 2], names[i * 2 + 1], "An option with a longer description, to fill out the help text");
+                }
+            }
+            request.setCompletion(true);
+            gSink = request.parse(7, argv);
+            times.push_back(std::chrono::duration<double, std::nano>(Clock::now() - opStart).count());
+        } while(times.size() < 100 || std::chrono::duration<double>(Clock::now() - start).count() < gMinSeconds);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        dup2(savedStdout, 1);
+        close(savedStdout);
+        close(devNull);
+
+        std::sort(times.begin(), times.end());
+        m.mBenchmark = "complete_request";
+        m.mNsPerOp = seconds * 1e9 / times.size();
+        m.mAllocsPerOp = (double)(gAllocations.load() - allocations) / times.size();
+        m.mPeakBytes = gPeakBytes.load() - baseBytes;
+        m.mP99Ns = times[times.size() * 99 / 100];
+        Print(m);
+        m.mP99Ns = 0;
+#endif
+    }
+}
+
+/**
+ * @brief Failing on an unknown argument, which looks for the closest known names to suggest.
+ * A typo of a known name, and a name close to none of them, which the distance bound cuts off early
+ */
+void BenchSuggest() {
+    if(!Enabled("suggest")) return;
+    for(size_t count = 10; count <= 10000; count *= 10) {
+        ArgParser parser;
+        AddOptions(parser, count, 20);
+        ArgParserResult result;
+        const char* typo[] = { "program", "--optoin-7" };
+        const char* far[] = { "program", "--zzzzzzzzzz" };
+        Measurement m;
+        m.mOptions = count;
+        m.mTokens = 2;
+        m.mFlagPercent = 20;
+        m.mErrorPercent = 100;
+        m.mBenchmark = "suggest_typo";
+        Measure(m, [&]() { gSink = (uint32_t)parser.tryParse(2, typo, result).mSuggestionCount; });
+        m.mBenchmark = "suggest_far";
+        Measure(m, [&]() { gSink = (uint32_t)parser.tryParse(2, far, result).mSuggestionCount; });
+    }
+}
+
+/**
+ * @brief BulkParser over 100,000 lines as the threads grow. ns_per_op is per line, over all threads
+ */
+void BenchBulk() {
+    if(!Enabled("bulk")) return;
+    const size_t lineCount = 100000;
+    ArgParser parser;
+    AddOptions(parser, 100, 20);
+    String input;
+    for(size_t l = 0; l < lineCount; l++) {
+        input += "program";
+        for(size_t i = 0; i < 8; i++) {
+            size_t option = (l * 7919 + i * 13) % 100;
+            input += " --option-" + std::to_string(option);
+            if(!IsFlag(option, 20)) {
+                input += i % 2 == 0 ? " 'a value'" : "=value";
+            }
+        }
+        input += '\n';
+    }
+
+    size_t maxThreads = std::thread::hardware_concurrency();
+    if(maxThreads == 0) maxThreads = 1;
+    for(int ordered = 1; ordered >= 0; ordered--)
+    for(size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        BulkParser bulk(parser);
+        bulk.setThreadCount(threadCount);
+        bulk.setOrder(ordered ? BulkParser::Ordered : BulkParser::Unordered);
+        bulk.parse(input); // Warm up
+        size_t runs = 0;
+        size_t allocations = gAllocations.load();
+        size_t baseBytes = gLiveBytes.load();
+        gPeakBytes.store(baseBytes);
+        Clock::time_point start = Clock::now();
+        do {
+            gSink = (uint32_t)bulk.parse(input, [](const BulkResult &line) {
+                gSink = (uint32_t)line.mText.length();
+            }).mLines;
+            runs++;
+        } while(std::chrono::duration<double>(Clock::now() - start).count() < gMinSeconds);
+        Measurement m;
+        m.mBenchmark = ordered ? "bulk_ordered" : "bulk_unordered";
+        m.mOptions = 100;
+        m.mTokens = lineCount;
+        m.mForm = "mixed";
+        m.mValueLength = 5;
+        m.mFlagPercent = 20;
+        m.mThreads = threadCount;
+        m.mNsPerOp = NsPerOp(start, runs * lineCount);
+        m.mAllocsPerOp = (double)(gAllocations.load() - allocations) / (runs * lineCount);
+        m.mPeakBytes = gPeakBytes.load() - baseBytes;
+        Print(m);
+    }
+}
+
+/**
+ * @brief Loading a value for every argument from a config file, and from the environment, as the schema grows
+ */
+void BenchSources() {
+    if(!Enabled("sources")) return;
+    const char* path = "cpp_arg_parser_bench.ini";
+    for(size_t count = 10; count <= 10000; count *= 10) {
+        ArgParser parser;
+        AddOptions(parser, count, 0);
+        FILE* file = fopen(path, "wb");
+        if(file == NULL) {
+            std::cerr << "Could not write " << path << std::endl;
+            return;
+        }
+        for(size_t i = 0; i < count; i++) {
+            fprintf(file, "option-%zu = value\n", i);
+        }
+        fclose(file);
+
+        Measurement m;
+        m.mOptions = count;
+        m.mTokens = count;
+        m.mValueLength = 5;
+        m.mBenchmark = "sources_config";
+        Measure(m, [&]() {
+            parser.loadConfigFile(path);
+            parser.clearSources();
+        });
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        for(size_t i = 0; i < count; i++) {
+            String variable = "BENCH_OPTION_" + std::to_string(i);
+            setenv(variable.c_str(), "value", 1);
+            parser.setEnvVar("--option-" + std::to_string(i), variable);
+        }
+        m.mBenchmark = "sources_environment";
+        Measure(m, [&]() { parser.loadEnvironment(); });
+#endif
+    }
+    remove(path);
+}
+
+/**
+ * @brief Snapshotting a result, and attaching a reader to it, as the schema grows. The parser allocates
+ * from an Arena, which packs its allocations, so the snapshot is written after an unaligned allocation
+ */
+void BenchSnapshot() {
+    if(!Enabled("snapshot")) return;
+    for(size_t count = 10; count <= 10000; count *= 10) {
+        Arena arena;
+        ArgParser parser(&arena);
+        AddOptions(parser, count, 0);
+        CommandLine line;
+        line.mTokens.push_back("program");
+        for(size_t i = 0; i < count; i += 3) {
+            line.mTokens.push_back("--option-" + std::to_string(i) + "=value-" + std::to_string(i));
+        }
+        line.finish();
+        parser.parse((int)line.mArgv.size(), line.mArgv.data());
+
+        arena.allocate(1, 1); // Leave the arena unaligned, as odd-length strings would
+        SnapshotBuffer snapshot = parser.snapshot();
+        ArgSnapshot reader(parser);
+
+        Measurement m;
+        m.mOptions = count;
+        m.mTokens = line.mArgv.size();
+        m.mForm = "joined";
+        m.mBenchmark = "snapshot_write";
+        Measure(m, [&]() { gSink = (uint32_t)parser.snapshot().size(); });
+        m.mBenchmark = "snapshot_attach";
+        Measure(m, [&]() {
+            reader.attach(snapshot.data(), snapshot.size());
+            gSink = (uint32_t)reader["--option-0"].mValue.length();
+        });
+    }
+}
+
+/**
+ * @brief Parse throughput with many threads sharing one finalized parser, each with its own result.
+ * ns_per_op is per parse, per thread
+ */
+void BenchParseThreads() {
+    if(!Enabled("threads")) return;
+    const size_t parsesPerThread = 20000;
+    ArgParser parser;
+    AddOptions(parser, 100, 0);
+    parser.setZeroCopy(true);
+
+    Vector<String> names = MakeNames(100);
+    CommandLine line;
+    line.mTokens.push_back("program");
+    for(size_t i = 0; i < names.size(); i += 10) {
+        line.mTokens.push_back(names[i] + "=value");
+        line.mTokens.push_back(names[i + 1]);
+        line.mTokens.push_back("value");
+    }
+    line.finish();
+
+    size_t maxThreads = std::thread::hardware_concurrency();
+    if(maxThreads == 0) maxThreads = 1;
+    for(size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        Vector<std::thread> threads;
+        size_t allocations = gAllocations.load();
+        size_t baseBytes = gLiveBytes.load();
+        gPeakBytes.store(baseBytes);
+        Clock::time_point start = Clock::now();
+        for(size_t t = 0; t < threadCount; t++) {
+            threads.push_back(std::thread([&]() {
+                ArgParserResult result;
+                for(size_t i = 0; i < parsesPerThread; i++) {
+                    parser.parse((int)line.mArgv.size(), line.mArgv.data(), result);
+                }
+                gSink = (uint32_t)result["--option-0"].asStringView().length();
+            }));
+        }
+        for(std::thread &thread : threads) {
+            thread.join();
+        }
+        Measurement m;
+        m.mBenchmark = "threads_parse";
+        m.mOptions = 100;
+        m.mTokens = line.mArgv.size();
+        m.mForm = "mixed";
+        m.mValueLength = 5;
+        m.mThreads = threadCount;
+        m.mNsPerOp = NsPerOp(start, parsesPerThread);
+        m.mAllocsPerOp = (double)(gAllocations.load() - allocations) / (parsesPerThread * threadCount);
+        m.mPeakBytes = gPeakBytes.load() - baseBytes;
+        Print(m);
+    }
+}
+
+}
+
+/**
+ * @brief Entry point for the benchmarks. Prints CSV to stdout, a row per case, to diff between releases.
+ * See --help for the options
+ */
+int main(int argc, char** argv) {
+    ArgParser args;
+    args.setProgramName("cpp_arg_parser_bench");
+    args.addArg("--filter", "-f", "Only run the benchmarks starting with this. e.g. parse, lookup, convert, list, choices, help, complete, suggest, bulk, sources, snapshot, threads");
+    args.addArg("--min-time", "-t", "Measure each case for at least this many seconds. 0.05 by default");
+    args.addFlag("--help", "-h", "Print this");
+    args.setCatchExceptions(true);
+    if(!args.parse(argc, argv)) {
+        return 1;
+    }
+    if(args["--help"].asBool()) {
+        printf("%s", args.getHelp().c_str());
+        return 0;
+    }
+    gFilter = args["--filter"].asString();
+    gMinSeconds = args["--min-time"].asDouble(gMinSeconds);
+
+    PrintHeader();
+    BenchParse();
+    BenchLookup();
+    BenchConvert();
+    BenchList();
+    BenchChoices();
+    BenchHelp();
+    BenchComplete();
+    BenchSuggest();
+    BenchBulk();
+    BenchSources();
+    BenchSnapshot();
+    BenchParseThreads();
+    return 0;
+}
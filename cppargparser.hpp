@@ -4,11 +4,40 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 
+#include <ctype.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CPP_ARG_PARSER_HAS_MMAP
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+extern char** environ;
+#endif
 
 // #define DEBUG_CPP_ARG_PARSER
 
@@ -18,557 +47,5244 @@
 #define LOG(...)
 #endif
 
+// Define to count and time parses. See ParseStats. Otherwise the counting compiles to nothing
+// #define CPP_ARG_PARSER_STATS
+
+#ifdef CPP_ARG_PARSER_STATS
+#include <chrono>
+#define ARG_STATS(...) __VA_ARGS__
+#else
+#define ARG_STATS(...)
+#endif
+
 namespace argparse {
 
 using String = std::string;
+
+#ifdef CPP_ARG_PARSER_STATS
+/// Counting for ParseStats
+namespace detail {
+    using StatsClock = std::chrono::steady_clock;
+
+    inline uint64_t ElapsedNs(StatsClock::time_point pStart) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - pStart).count();
+    }
+
+    /// @brief Adds the time it's alive for to a total
+    class PhaseTimer {
+        uint64_t &mTotal;
+        StatsClock::time_point mStart;
+    public:
+        explicit PhaseTimer(uint64_t &pTotal) : mTotal(pTotal), mStart(StatsClock::now()) {}
+        ~PhaseTimer() { this->mTotal += ElapsedNs(this->mStart); }
+    };
+
+    /// @brief Allocations through Allocator on this thread, ever
+    inline size_t& ThreadAllocations() {
+        static thread_local size_t count = 0;
+        return count;
+    }
+    inline size_t& ThreadAllocatedBytes() {
+        static thread_local size_t bytes = 0;
+        return bytes;
+    }
+}
+#endif
+
+/**
+ * @brief Where the parser gets its memory from. Same idea as std::pmr::memory_resource
+ * Implement it to plug in your own allocator, or use an Arena.
+ */
+class MemoryResource {
+public:
+    virtual ~MemoryResource() {}
+    virtual void* allocate(size_t pBytes, size_t pAlign) = 0;
+    virtual void deallocate(void* pPtr, size_t pBytes, size_t pAlign) = 0;
+};
+
+/// @brief Plain new and delete
+class NewDeleteResource : public MemoryResource {
+public:
+    void* allocate(size_t pBytes, size_t) override {
+        return ::operator new(pBytes);
+    }
+    void deallocate(void* pPtr, size_t, size_t) override {
+        ::operator delete(pPtr);
+    }
+};
+
+/// @brief The resource used when none is given
+inline MemoryResource* DefaultResource() {
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+/**
+ * @brief STL allocator that forwards to a MemoryResource. Same idea as std::pmr::polymorphic_allocator
+ * Containers moved into each other keep their memory, so views into them stay valid.
+ */
+template<typename T>
+class Allocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    MemoryResource* mResource;
+
+    Allocator() : mResource(DefaultResource()) {}
+    Allocator(MemoryResource* pResource) : mResource(pResource) {}
+    template<typename U>
+    Allocator(const Allocator<U> &other) : mResource(other.mResource) {}
+
+    T* allocate(size_t n) {
+        ARG_STATS(detail::ThreadAllocations()++; detail::ThreadAllocatedBytes() += n * sizeof(T);)
+        return (T*)this->mResource->allocate(n * sizeof(T), alignof(T));
+    }
+    void deallocate(T* pPtr, size_t n) {
+        this->mResource->deallocate(pPtr, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    bool operator==(const Allocator<U> &other) const { return this->mResource == other.mResource; }
+    template<typename U>
+    bool operator!=(const Allocator<U> &other) const { return this->mResource != other.mResource; }
+};
+
 template<typename T>
-using Vector = std::vector<T>;
+using Vector = std::vector<T, Allocator<T>>;
 template<typename K, typename V>
 using Map = std::map<K, V>;
 
-struct ArgDef {
-    String mName;
-    Vector<String> mAliases;
-    String mDescription;
-    bool mOptional;
-    bool mIsFlag;
-    static std::shared_ptr<ArgDef> Create() {
-        return std::make_shared<ArgDef>();
+/**
+ * @brief A bump allocator. Hands out memory from large blocks, and frees it all in one go with release()
+ * Individual deallocations are ignored. Can start with a caller-provided buffer (e.g. on the stack)
+ * and gets more blocks, each twice the size of the last, from the upstream resource when that runs out.
+ */
+class Arena : public MemoryResource {
+    struct Block {
+        Block* mNext;
+        size_t mSize;
+    };
+    MemoryResource* mUpstream;
+    Block* mBlocks = NULL;
+    char* mBuffer = NULL;
+    size_t mBufferSize = 0;
+    char* mPos = NULL;
+    char* mEnd = NULL;
+    size_t mNextBlockSize;
+
+    void addBlock(size_t pMinSize) {
+        size_t size = this->mNextBlockSize;
+        while(size < pMinSize + sizeof(Block)) {
+            size *= 2;
+        }
+        Block* block = (Block*)this->mUpstream->allocate(size, alignof(Block));
+        block->mNext = this->mBlocks;
+        block->mSize = size;
+        this->mBlocks = block;
+        this->mPos = (char*)(block + 1);
+        this->mEnd = (char*)block + size;
+        this->mNextBlockSize = size * 2;
+    }
+public:
+    explicit Arena(size_t pBlockSize=4096, MemoryResource* pUpstream=DefaultResource())
+        : mUpstream(pUpstream), mNextBlockSize(pBlockSize > 0 ? pBlockSize : 4096) {}
+    /// @brief Start with the given buffer, which must outlive the arena
+    Arena(void* pBuffer, size_t pSize, MemoryResource* pUpstream=DefaultResource())
+        : mUpstream(pUpstream), mBuffer((char*)pBuffer), mBufferSize(pSize),
+          mPos((char*)pBuffer), mEnd((char*)pBuffer + pSize), mNextBlockSize(pSize > 0 ? pSize * 2 : 4096) {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena &&other) : Arena(4096, other.mUpstream) {
+        *this = std::move(other);
+    }
+    Arena& operator=(Arena &&other) {
+        this->release();
+        this->mUpstream = other.mUpstream;
+        this->mBlocks = other.mBlocks;
+        this->mBuffer = other.mBuffer;
+        this->mBufferSize = other.mBufferSize;
+        this->mPos = other.mPos;
+        this->mEnd = other.mEnd;
+        this->mNextBlockSize = other.mNextBlockSize;
+        other.mBlocks = NULL;
+        other.mBuffer = NULL;
+        other.mBufferSize = 0;
+        other.mPos = NULL;
+        other.mEnd = NULL;
+        return *this;
+    }
+    ~Arena() {
+        this->release();
     }
-};
-using ArgDefPtr = std::shared_ptr<ArgDef>;
 
-struct ArgPair {
-    ArgDefPtr mArg;
-    String mValue;
-    static std::shared_ptr<ArgPair> Create() {
-        return std::make_shared<ArgPair>();
+    void* allocate(size_t pBytes, size_t pAlign) override {
+        uintptr_t pos = ((uintptr_t)this->mPos + pAlign - 1) & ~(uintptr_t)(pAlign - 1);
+        if(this->mPos == NULL || pos + pBytes > (uintptr_t)this->mEnd) {
+            this->addBlock(pBytes + pAlign);
+            pos = ((uintptr_t)this->mPos + pAlign - 1) & ~(uintptr_t)(pAlign - 1);
+        }
+        this->mPos = (char*)(pos + pBytes);
+        return (void*)pos;
+    }
+    void deallocate(void*, size_t, size_t) override {}
+
+    /// @brief The bytes got from upstream, in blocks. Not counting a caller-provided buffer
+    size_t reserved() const {
+        size_t total = 0;
+        for(const Block* block = this->mBlocks; block != NULL; block = block->mNext) {
+            total += block->mSize;
+        }
+        return total;
+    }
+
+    /// @brief Free everything allocated from the arena. Anything still using it must be gone
+    void release() {
+        while(this->mBlocks != NULL) {
+            Block* next = this->mBlocks->mNext;
+            this->mUpstream->deallocate(this->mBlocks, this->mBlocks->mSize, alignof(Block));
+            this->mBlocks = next;
+        }
+        this->mPos = this->mBuffer;
+        this->mEnd = this->mBuffer + this->mBufferSize;
     }
+};
+
+/**
+ * @brief A non-owning, read-only view of a range of characters.
+ * Used to refer to slices of argv (and of the argument definitions) without
+ * copying them. The viewed memory must outlive the view.
+ */
+class StringView {
+    const char* mData;
+    size_t mLength;
 public:
-    String asString(String pDefault="") const {
-        if(this->mValue.length() == 0) return pDefault;
-        return this->mValue;
+    static const size_t npos = (size_t)-1;
+
+    StringView() : mData(""), mLength(0) {}
+    StringView(const char* pStr) : mData(pStr), mLength(strlen(pStr)) {}
+    StringView(const char* pStr, size_t pLength) : mData(pStr), mLength(pLength) {}
+    StringView(const String &pStr) : mData(pStr.data()), mLength(pStr.length()) {}
+
+    const char* data() const { return this->mData; }
+    size_t length() const { return this->mLength; }
+    size_t size() const { return this->mLength; }
+    bool empty() const { return this->mLength == 0; }
+    const char* begin() const { return this->mData; }
+    const char* end() const { return this->mData + this->mLength; }
+    char operator[](size_t pIndex) const { return this->mData[pIndex]; }
+
+    /// @brief Get a sub-view. Clamped to the bounds of this view
+    StringView substr(size_t pPos, size_t pLength=npos) const {
+        if(pPos > this->mLength) pPos = this->mLength;
+        size_t remaining = this->mLength - pPos;
+        if(pLength > remaining) pLength = remaining;
+        return StringView(this->mData + pPos, pLength);
     }
-    int asInt(int pDefault=0) const { 
-        if(this->mValue.length() == 0) return pDefault;
-        return std::stoi(this->mValue);
+
+    /// @brief Find the first character that is also in pChars. npos if there are none
+    size_t find_first_of(StringView pChars) const {
+        const char* result = std::find_first_of(this->begin(), this->end(), pChars.begin(), pChars.end());
+        return result == this->end() ? npos : (size_t)(result - this->mData);
     }
-    long asLong(long pDefault=0) const { 
-        if(this->mValue.length() == 0) return pDefault;
-        return std::stol(this->mValue);
+
+    bool startsWith(StringView pPrefix) const {
+        return this->mLength >= pPrefix.mLength && (pPrefix.mLength == 0 || memcmp(this->mData, pPrefix.mData, pPrefix.mLength) == 0);
     }
-    float asFloat(float pDefault=0) const { 
-        if(this->mValue.length() == 0) return pDefault;
-        return std::stof(this->mValue);
+
+    int compare(StringView pOther) const {
+        size_t len = std::min(this->mLength, pOther.mLength);
+        int result = len == 0 ? 0 : memcmp(this->mData, pOther.mData, len);
+        if(result != 0) return result;
+        if(this->mLength == pOther.mLength) return 0;
+        return this->mLength < pOther.mLength ? -1 : 1;
     }
-    double asDouble(long pDefault=0) const { 
-        if(this->mValue.length() == 0) return pDefault;
-        return std::stod(this->mValue);
+
+    /// @brief Copy the viewed characters into a new string
+    String toString() const {
+        return String(this->mData, this->mLength);
     }
-    bool asBool(bool pDefault=false) const { 
-        if(this->mValue.length() == 0) return pDefault;
-        return this->mValue == "true" || this->mValue == "yes";
+
+    friend bool operator==(StringView a, StringView b) {
+        return a.mLength == b.mLength && (a.mLength == 0 || memcmp(a.mData, b.mData, a.mLength) == 0);
+    }
+    friend bool operator!=(StringView a, StringView b) { return !(a == b); }
+    friend bool operator<(StringView a, StringView b) { return a.compare(b) < 0; }
+    friend std::ostream& operator<<(std::ostream &out, StringView str) {
+        return out.write(str.data(), str.length());
     }
 };
-using ArgPairPtr = std::shared_ptr<ArgPair>;
 
-struct ArgParserResult {
-    Vector<ArgPairPtr> mResults;
-    Map<String, ArgPairPtr> mResultMap;
+/**
+ * @brief Iterates over the non-empty fields of a comma-separated string, as views into it.
+ * e.g. for(StringView alias : CsvRange("-t,-h")) ...
+ */
+class CsvRange {
+    StringView mStr;
+public:
+    class iterator {
+        const char* mEnd;
+        StringView mField;
+        /// Find the next non-empty field starting at pPos. At the end, mField is empty and at mEnd
+        void seek(const char* pPos) {
+            while(pPos != this->mEnd && *pPos == ',') pPos++;
+            const char* fieldEnd = std::find(pPos, this->mEnd, ',');
+            this->mField = StringView(pPos, fieldEnd - pPos);
+        }
+    public:
+        iterator(const char* pPos, const char* pEnd) : mEnd(pEnd) { this->seek(pPos); }
+        StringView operator*() const { return this->mField; }
+        iterator& operator++() {
+            this->seek(this->mField.end());
+            return *this;
+        }
+        bool operator!=(const iterator &other) const { return this->mField.data() != other.mField.data(); }
+    };
+
+    CsvRange(StringView pStr) : mStr(pStr) {}
+    iterator begin() const { return iterator(this->mStr.begin(), this->mStr.end()); }
+    iterator end() const { return iterator(this->mStr.end(), this->mStr.end()); }
+};
+
+/**
+ * @brief Splits a command line into tokens the way a POSIX shell would.
+ * Handles 'single quotes', "double quotes" and backslash escapes. Nothing is expanded.
+ * Tokens that need no unquoting are returned as views into the input; the rest are
+ * unquoted into a caller-provided scratch buffer.
+ */
+class ShellTokenizer {
+    StringView mInput;
+    size_t mPos = 0;
+    /// The input, if it may be unquoted in place. NULL otherwise
+    char* mWritable = NULL;
 
-    void addResult(ArgPairPtr result) {
-        mResults.push_back(result);
-        mResultMap.insert(std::make_pair(result->mArg->mName, result));
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
     }
+public:
+    enum Status {
+        Token,              ///< Found a token
+        End,                ///< No more tokens
+        UnterminatedQuote   ///< A quote was opened and never closed
+    };
 
-    void clear() {
-        mResults.clear();
-        mResultMap.clear();
+    explicit ShellTokenizer(StringView pInput) : mInput(pInput) {}
+    /// @brief Tokenize writable input, unquoting tokens in place so no scratch buffer is needed
+    ShellTokenizer(char* pInput, size_t pLength) : mInput(pInput, pLength), mWritable(pInput) {}
+
+    /// @brief The offset into the input the tokenizer has reached. After UnterminatedQuote, where the quote is
+    size_t position() const { return this->mPos; }
+
+    /**
+     * @brief Get the next token
+     * @param pToken Set to the token
+     * @param pScratch Where to write tokens that need unquoting. Needs room for as many characters
+     *  as are left in the input. Advanced past what's written.
+     *  NULL to unquote in place, if the tokenizer was given writable input
+     */
+    Status next(StringView &pToken, char* &pScratch) {
+        const char* in = this->mInput.data();
+        size_t len = this->mInput.length();
+        size_t pos = this->mPos;
+        while(pos < len && IsSpace(in[pos])) pos++;
+        if(pos == len) {
+            this->mPos = pos;
+            return End;
+        }
+        // Fast path: no quotes or escapes, so the token is a view of the input
+        size_t start = pos;
+        while(pos < len && !IsSpace(in[pos]) && in[pos] != '\'' && in[pos] != '"' && in[pos] != '\\') pos++;
+        if(pos == len || IsSpace(in[pos])) {
+            this->mPos = pos;
+            pToken = StringView(in + start, pos - start);
+            return Token;
+        }
+        // Slow path: unquote into the scratch buffer. Or in place: never writing more than has been read,
+        // the output can't overtake the input
+        char* tokenStart = pScratch != NULL ? pScratch : this->mWritable + start;
+        char* out = tokenStart;
+        memmove(out, in + start, pos - start);
+        out += pos - start;
+        while(pos < len && !IsSpace(in[pos])) {
+            char c = in[pos++];
+            if(c == '\'') {
+                const char* close = (const char*)memchr(in + pos, '\'', len - pos);
+                if(close == NULL) {
+                    this->mPos = pos - 1;
+                    return UnterminatedQuote;
+                }
+                memmove(out, in + pos, close - (in + pos));
+                out += close - (in + pos);
+                pos = close - in + 1;
+            } else if(c == '"') {
+                size_t quotePos = pos - 1;
+                while(pos < len && in[pos] != '"') {
+                    // Within double quotes, a backslash only escapes these
+                    if(in[pos] == '\\' && pos + 1 < len && strchr("\"\\$`\n", in[pos + 1]) != NULL) {
+                        pos++;
+                    }
+                    *out++ = in[pos++];
+                }
+                if(pos == len) {
+                    this->mPos = quotePos;
+                    return UnterminatedQuote;
+                }
+                pos++;
+            } else if(c == '\\' && pos < len) {
+                *out++ = in[pos++];
+            } else {
+                *out++ = c;
+            }
+        }
+        this->mPos = pos;
+        pToken = StringView(tokenStart, out - tokenStart);
+        if(pScratch != NULL) {
+            pScratch = out;
+        }
+        return Token;
     }
 };
 
-class UnknownArgument : public std::exception {
-    String message, key;
+/**
+ * @brief A whole file, read-only, in memory.
+ * Memory-mapped where the platform supports it, so pages are only read in as they're used.
+ * Read in one go otherwise.
+ */
+class MappedFile {
+    char* mData = NULL;
+    size_t mSize = 0;
+    bool mMapped = false;
+    Vector<char> mBuffer;
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+    /// Identifies the file, for isSameFile
+    dev_t mDevice = 0;
+    ino_t mInode = 0;
+#else
+    String mPath;
+#endif
 public:
-    UnknownArgument(String key) {
-        this->message = "Unknown argument: " + key;
-        this->key = key;
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile &&other) {
+        *this = std::move(other);
+    }
+    MappedFile& operator=(MappedFile &&other) {
+        this->close();
+        this->mData = other.mData;
+        this->mSize = other.mSize;
+        this->mMapped = other.mMapped;
+        this->mBuffer = std::move(other.mBuffer);
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        this->mDevice = other.mDevice;
+        this->mInode = other.mInode;
+#else
+        this->mPath = std::move(other.mPath);
+#endif
+        other.mData = NULL;
+        other.mSize = 0;
+        other.mMapped = false;
+        return *this;
+    }
+    ~MappedFile() {
+        this->close();
     }
 
-    const String& getKey() const {
-        return this->key;
+    /**
+     * @brief Map (or read) the file at the given path
+     * @param pCopyOnWrite Make the memory writable (see data). Writes only copy the pages they touch,
+     *  and never reach the file
+     * @return False if it couldn't be opened
+     */
+    bool open(const char* pPath, bool pCopyOnWrite=false) {
+        this->close();
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        int fd = ::open(pPath, O_RDONLY);
+        if(fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if(fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        this->mDevice = info.st_dev;
+        this->mInode = info.st_ino;
+        if(info.st_size > 0) {
+            int protection = pCopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+            void* data = mmap(NULL, (size_t)info.st_size, protection, MAP_PRIVATE, fd, 0);
+            if(data == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+#ifdef MADV_SEQUENTIAL
+            madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+#endif
+            this->mData = (char*)data;
+            this->mSize = (size_t)info.st_size;
+            this->mMapped = true;
+        }
+        ::close(fd);
+        return true;
+#else
+        FILE* file = fopen(pPath, "rb");
+        if(file == NULL) {
+            return false;
+        }
+        char chunk[65536];
+        size_t read;
+        while((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            this->mBuffer.insert(this->mBuffer.end(), chunk, chunk + read);
+        }
+        fclose(file);
+        (void)pCopyOnWrite; // The buffer is always writable
+        this->mData = this->mBuffer.data();
+        this->mSize = this->mBuffer.size();
+        this->mPath = pPath;
+        return true;
+#endif
     }
 
-	const char * what () const throw () {
-    	return this->message.c_str();
+    void close() {
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        if(this->mMapped) {
+            munmap((void*)this->mData, this->mSize);
+        }
+#endif
+        this->mData = NULL;
+        this->mSize = 0;
+        this->mMapped = false;
+        this->mBuffer.clear();
+    }
+
+    StringView view() const {
+        return StringView(this->mData != NULL ? this->mData : "", this->mSize);
+    }
+
+    /// @brief The contents, to write to. Only if opened copy-on-write. NULL if the file is empty
+    char* data() {
+        return this->mData;
+    }
+
+    /// @brief True if both are open on the same file, even if by different paths (where the platform can tell)
+    bool isSameFile(const MappedFile &pOther) const {
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        return this->mDevice == pOther.mDevice && this->mInode == pOther.mInode;
+#else
+        return this->mPath == pOther.mPath;
+#endif
     }
 };
-class MissingArgument : public std::exception {
-    String message, key;
+
+/**
+ * @brief Open-addressing hash table from names to small integer values.
+ * Linear probing over a power-of-two table that is kept at most half full,
+ * so a lookup costs one hash and (nearly always) one compare, no matter how many keys.
+ * Keys are views; the strings they refer to must outlive the index.
+ */
+class ArgIndex {
 public:
-    MissingArgument(String key) {
-        this->message = "Missing mandatory argument: " + key;
-        this->key = key;
+    /// Returned by find when the key isn't present
+    static const uint32_t npos = 0xFFFFFFFF;
+private:
+    struct Entry {
+        StringView mKey;
+        uint32_t mHash;
+        uint32_t mValue; ///< npos for an empty slot
+    };
+    Vector<Entry> mTable;
+    size_t mMask = 0;
+    size_t mCount = 0;
+
+    void grow() {
+        Vector<Entry> old(this->mTable.get_allocator());
+        old.swap(this->mTable);
+        this->reset(old.empty() ? 4 : old.size());
+        // The keys are already unique, and their hashes kept, so they're just placed
+        for(const Entry &entry : old) {
+            if(entry.mValue != npos) {
+                size_t i = entry.mHash & this->mMask;
+                while(this->mTable[i].mValue != npos) {
+                    i = (i + 1) & this->mMask;
+                }
+                this->mTable[i] = entry;
+                this->mCount++;
+            }
+        }
     }
+public:
+    explicit ArgIndex(MemoryResource* pResource=DefaultResource()) : mTable(pResource) {}
 
-    const String& getKey() const {
-        return this->key;
+    /// @brief Hash of the key bytes, 8 at a time. Names are mostly longer than a few bytes, and a byte
+    /// at a time was most of the cost of adding thousands of arguments
+    static uint32_t Hash(StringView pKey) {
+        const char* pos = pKey.data();
+        size_t remaining = pKey.length();
+        uint64_t hash = 0x9E3779B97F4A7C15ull ^ remaining;
+        uint64_t word;
+        for(; remaining >= 8; pos += 8, remaining -= 8) {
+            memcpy(&word, pos, 8);
+            hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+            hash ^= hash >> 32;
+        }
+        word = 0;
+        memcpy(&word, pos, remaining);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 29;
+        return (uint32_t)(hash ^ (hash >> 32));
     }
 
-	const char * what () const throw () {
-    	return this->message.c_str();
+    /// @brief Remove all keys, and size the table to hold pCount keys without growing
+    void reset(size_t pCount) {
+        size_t capacity = 8;
+        while(capacity < pCount * 2) {
+            capacity <<= 1;
+        }
+        Entry empty = { StringView(), 0, npos };
+        this->mTable.assign(capacity, empty);
+        this->mMask = capacity - 1;
+        this->mCount = 0;
+    }
+
+    /**
+     * @brief Add a key. If it's already present, the existing value is kept
+     * @return False if the key was already present
+     */
+    bool insert(StringView pKey, uint32_t pValue) {
+        if((this->mCount + 1) * 2 > this->mTable.size()) {
+            this->grow();
+        }
+        uint32_t hash = Hash(pKey);
+        for(size_t i = hash & this->mMask;; i = (i + 1) & this->mMask) {
+            Entry &entry = this->mTable[i];
+            if(entry.mValue == npos) {
+                entry.mKey = pKey;
+                entry.mHash = hash;
+                entry.mValue = pValue;
+                this->mCount++;
+                return true;
+            }
+            if(entry.mHash == hash && entry.mKey == pKey) {
+                return false;
+            }
+        }
+    }
+
+    /// @brief Get the value for a key, or npos if it isn't present
+    uint32_t find(StringView pKey) const {
+        if(this->mCount == 0) return npos;
+        uint32_t hash = Hash(pKey);
+        for(size_t i = hash & this->mMask;; i = (i + 1) & this->mMask) {
+            const Entry &entry = this->mTable[i];
+            if(entry.mValue == npos) return npos;
+            if(entry.mHash == hash && entry.mKey == pKey) return entry.mValue;
+        }
+    }
+
+    /// @brief The key stored equal to pKey, or NULL if it isn't present. e.g. to share its memory
+    const char* findKey(StringView pKey) const {
+        if(this->mCount == 0) return NULL;
+        uint32_t hash = Hash(pKey);
+        for(size_t i = hash & this->mMask;; i = (i + 1) & this->mMask) {
+            const Entry &entry = this->mTable[i];
+            if(entry.mValue == npos) return NULL;
+            if(entry.mHash == hash && entry.mKey == pKey) return entry.mKey.data();
+        }
     }
+
+    size_t size() const { return this->mCount; }
+    /// @brief The memory the table takes
+    size_t bytes() const { return this->mTable.capacity() * sizeof(Entry); }
 };
-class MissingValue : public std::exception {
-    String message, key;
+
+/**
+ * @brief Owns copies of strings, handing out NUL-terminated pointers that stay valid for the pool's lifetime.
+ * Strings are packed into large blocks, so storing many small strings costs few allocations.
+ * Interned strings are stored once, however many times they're interned.
+ */
+class StringPool {
+    Arena mArena;
+    /// The interned strings. Values unused
+    ArgIndex mInterned;
+    /// The bytes stored, including the NULs
+    size_t mBytes = 0;
 public:
-    MissingValue(String key) {
-        this->message = "Found argument " + key + "with no value";
-        this->key = key;
+    explicit StringPool(MemoryResource* pUpstream=DefaultResource()) : mArena(4096, pUpstream), mInterned(pUpstream) {}
+
+    /// @brief Store a copy of the string. For strings that won't repeat, e.g. argument names
+    const char* store(StringView pStr) {
+        if(pStr.empty()) {
+            return "";
+        }
+        char* dest = (char*)this->mArena.allocate(pStr.length() + 1, 1);
+        memcpy(dest, pStr.data(), pStr.length());
+        dest[pStr.length()] = '\0';
+        this->mBytes += pStr.length() + 1;
+        return dest;
     }
 
-    const String& getKey() const {
-        return this->key;
+    /// @brief Store the string, unless an equal one was interned already, in which case that's returned
+    const char* intern(StringView pStr) {
+        if(pStr.empty()) {
+            return "";
+        }
+        const char* found = this->mInterned.findKey(pStr);
+        if(found != NULL) {
+            return found;
+        }
+        const char* stored = this->store(pStr);
+        this->mInterned.insert(StringView(stored, pStr.length()), 0);
+        return stored;
     }
 
-	const char * what () const throw () {
-    	return this->message.c_str();
+    /// @brief The bytes of the strings stored, including their NULs
+    size_t bytes() const { return this->mBytes; }
+    /// @brief The bytes reserved for them, in blocks
+    size_t reserved() const { return this->mArena.reserved(); }
+    /// @brief The memory the index of interned strings takes
+    size_t indexBytes() const { return this->mInterned.bytes(); }
+};
+
+/// Compile-time helpers for ArgDef and ArgDefsAreUnique. Recursive, as C++11 constexpr functions must be
+namespace detail {
+    constexpr bool IsFieldEnd(char c) {
+        return c == ',' || c == '\0';
+    }
+    /// The start of the field after the one at pPos, or the terminating NUL
+    constexpr const char* NextField(const char* pPos) {
+        return *pPos == '\0' ? pPos : (*pPos == ',' ? pPos + 1 : NextField(pPos + 1));
+    }
+    constexpr bool FieldEq(const char* a, const char* b) {
+        return IsFieldEnd(*a) ? IsFieldEnd(*b) : (*a == *b && FieldEq(a + 1, b + 1));
+    }
+    /// FNV-1a hash of the field at pPos
+    constexpr uint32_t FieldHash(const char* pPos, uint32_t pHash=2166136261u) {
+        return IsFieldEnd(*pPos) ? pHash : FieldHash(pPos + 1, (pHash ^ (unsigned char)*pPos) * 16777619u);
+    }
+    /// One of 64 bits, picked by the hash of the field at pPos
+    constexpr uint64_t FieldBit(const char* pPos) {
+        return (uint64_t)1 << (FieldHash(pPos) & 63);
+    }
+    /// The FieldBits of all the non-empty fields in the CSV string pFields, or'ed together
+    constexpr uint64_t CsvBits(const char* pFields) {
+        return *pFields == '\0' ? 0 : ((IsFieldEnd(*pFields) ? 0 : FieldBit(pFields)) | CsvBits(NextField(pFields)));
+    }
+    /// True if the field at pKey is one of the non-empty fields in the CSV string pFields
+    constexpr bool FieldInCsv(const char* pKey, const char* pFields) {
+        return *pFields != '\0'
+            && ((!IsFieldEnd(*pFields) && FieldEq(pKey, pFields)) || FieldInCsv(pKey, NextField(pFields)));
+    }
+}
+
+/**
+ * @brief The definition of an argument.
+ * A literal type, so a whole schema can be declared as a static constexpr table
+ * (see Arg, Flag and Final) and handed to ArgParser::addArgs without being copied.
+ * The strings are NUL-terminated, and owned by either static storage or the parser.
+ */
+struct ArgDef {
+    const char* mName;
+    /// Comma-separated aliases, e.g. "-t,-h". Iterate them with CsvRange
+    const char* mAliases;
+    const char* mDescription;
+    bool mOptional;
+    bool mIsFlag;
+    /// Keeps every occurrence, rather than just the first. See ArgParserResult::getAll
+    bool mRepeatable;
+    /// A bit per name and alias, picked by its hash. Lets ArgDefsAreUnique skip most comparisons
+    uint64_t mNameBits;
+    /// The environment variable the argument can also be set by, or NULL. See withEnv
+    const char* mEnvVar;
+    /// Constraints on the value, checked while parsing. See withChoices, withRange and withPattern
+    /// Comma-separated values it must be one of, or NULL
+    const char* mChoices;
+    /// A glob it must match, or NULL
+    const char* mPattern;
+    /// True if it must be a number within [mMin, mMax]
+    bool mHasRange;
+    double mMin;
+    double mMax;
+
+    /// @brief Define an argument that requires a value. See ArgParser::addArg
+    static constexpr ArgDef Arg(const char* pName, const char* pCSAliases, const char* pDesc="", bool opt=true) {
+        return ArgDef{pName, pCSAliases, pDesc, opt, false, false, detail::FieldBit(pName) | detail::CsvBits(pCSAliases), NULL, NULL, NULL, false, 0, 0};
+    }
+    /// @brief Define an argument that requires a value, and can be given many times. See ArgParser::addRepeatableArg
+    static constexpr ArgDef Repeatable(const char* pName, const char* pCSAliases, const char* pDesc="", bool opt=true) {
+        return ArgDef{pName, pCSAliases, pDesc, opt, false, true, detail::FieldBit(pName) | detail::CsvBits(pCSAliases), NULL, NULL, NULL, false, 0, 0};
+    }
+    /// @brief Define a flag. See ArgParser::addFlag
+    static constexpr ArgDef Flag(const char* pName, const char* pCSAliases, const char* pDesc="") {
+        return ArgDef{pName, pCSAliases, pDesc, true, true, false, detail::FieldBit(pName) | detail::CsvBits(pCSAliases), NULL, NULL, NULL, false, 0, 0};
+    }
+    /// @brief Define the final argument. See ArgParser::setFinalArg
+    static constexpr ArgDef Final(const char* pName, const char* pDesc="") {
+        return ArgDef{pName, "", pDesc, false, false, false, detail::FieldBit(pName), NULL, NULL, NULL, false, 0, 0};
+    }
+    /**
+     * @brief The same argument, that can also be set by the given environment variable. e.g.
+     *   ArgDef::Arg("--threads", "-t", "Number of threads").withEnv("MYPROGRAM_THREADS")
+     * See ArgParser::loadEnvironment
+     */
+    constexpr ArgDef withEnv(const char* pEnvVar) const {
+        return ArgDef{mName, mAliases, mDescription, mOptional, mIsFlag, mRepeatable, mNameBits, pEnvVar,
+            mChoices, mPattern, mHasRange, mMin, mMax};
+    }
+    /**
+     * @brief The same argument, whose value must be one of the given choices. e.g.
+     *   ArgDef::Arg("--mode", "-m", "How to run").withChoices("fast,safe,debug")
+     * The index of the one given is in ArgPair::mChoice, to switch on. See ArgParser::setChoices
+     */
+    constexpr ArgDef withChoices(const char* pCSChoices) const {
+        return ArgDef{mName, mAliases, mDescription, mOptional, mIsFlag, mRepeatable, mNameBits, mEnvVar,
+            pCSChoices, mPattern, mHasRange, mMin, mMax};
+    }
+    /// @brief The same argument, whose value must be a number from pMin to pMax. See ArgParser::setRange
+    constexpr ArgDef withRange(double pMin, double pMax) const {
+        return ArgDef{mName, mAliases, mDescription, mOptional, mIsFlag, mRepeatable, mNameBits, mEnvVar,
+            mChoices, mPattern, true, pMin, pMax};
+    }
+    /// @brief The same argument, whose value must match the glob. See ArgParser::setPattern
+    constexpr ArgDef withPattern(const char* pGlob) const {
+        return ArgDef{mName, mAliases, mDescription, mOptional, mIsFlag, mRepeatable, mNameBits, mEnvVar,
+            mChoices, pGlob, mHasRange, mMin, mMax};
+    }
+    /// @brief True if the value has any constraints
+    constexpr bool isConstrained() const {
+        return mChoices != NULL || mPattern != NULL || mHasRange;
     }
 };
+using ArgDefPtr = const ArgDef*;
+
+namespace detail {
+    /// True if the field at pKey, whose FieldBit is pBit, is a name or alias of pDefs[begin, end)
+    template<size_t N>
+    constexpr bool FieldInDefsLinear(const char* pKey, uint64_t pBit, const ArgDef (&pDefs)[N], size_t begin, size_t end) {
+        return begin != end
+            && (((pDefs[begin].mNameBits & pBit) != 0
+                    && (FieldEq(pKey, pDefs[begin].mName) || FieldInCsv(pKey, pDefs[begin].mAliases)))
+                || FieldInDefsLinear(pKey, pBit, pDefs, begin + 1, end));
+    }
+    /// As FieldInDefsLinear, but halves the range down to small runs, to keep the recursion shallow
+    template<size_t N>
+    constexpr bool FieldInDefs(const char* pKey, uint64_t pBit, const ArgDef (&pDefs)[N], size_t begin, size_t end) {
+        return end - begin <= 16 ? FieldInDefsLinear(pKey, pBit, pDefs, begin, end)
+            : FieldInDefs(pKey, pBit, pDefs, begin, begin + (end - begin) / 2)
+                || FieldInDefs(pKey, pBit, pDefs, begin + (end - begin) / 2, end);
+    }
+    /// True if none of the aliases from pAlias onward repeat within pDefs[index], or appear in any later definition
+    template<size_t N>
+    constexpr bool AliasesUnique(const char* pAlias, const ArgDef (&pDefs)[N], size_t index) {
+        return *pAlias == '\0'
+            || ((IsFieldEnd(*pAlias) || (!FieldInCsv(pAlias, NextField(pAlias))
+                    && !FieldInDefs(pAlias, FieldBit(pAlias), pDefs, index + 1, N)))
+                && AliasesUnique(NextField(pAlias), pDefs, index));
+    }
+    template<size_t N>
+    constexpr bool DefsUnique(const ArgDef (&pDefs)[N], size_t begin, size_t end) {
+        return end - begin == 0 ? true
+            : end - begin == 1 ? (!FieldInCsv(pDefs[begin].mName, pDefs[begin].mAliases)
+                && !FieldInDefs(pDefs[begin].mName, FieldBit(pDefs[begin].mName), pDefs, begin + 1, N)
+                && AliasesUnique(pDefs[begin].mAliases, pDefs, begin))
+            : DefsUnique(pDefs, begin, begin + (end - begin) / 2) && DefsUnique(pDefs, begin + (end - begin) / 2, end);
+    }
+}
 
 /**
- * @brief C++ Argument Parser main class
- * Prepare the parser arguments with addArg, addFlag, setFinalArg,
- * and config parsing parameters with setProgramName, setCatchExceptions, setPrintHelpOnCaughtException
+ * @brief True if no name or alias is used twice in the table. For use in a static_assert, e.g.
+ * static_assert(argparse::ArgDefsAreUnique(kArgs), "Duplicate argument names");
+ * Compares every pair of names, so compile time grows quadratically with the table size.
+ * Tables of several hundred arguments fit within GCC's default constexpr limits. Larger ones
+ * need a higher limit, e.g. -fconstexpr-ops-limit
  */
-class ArgParser {
-private:
-    // Stage 1 - Initialization and setup
-    /// The name of the program
-    String mProgramName;
-    /// Config: Catch errors instead of throwing them up the call stack
-    bool mCfgCatchExceptions;
-    /// Config: On a caught error, print help info to the console
-    bool mCfgPrintHelpOnCaughtException;
+template<size_t N>
+constexpr bool ArgDefsAreUnique(const ArgDef (&pDefs)[N]) {
+    return detail::DefsUnique(pDefs, 0, N);
+}
 
-    /// The configured arguments
-    Vector<ArgDefPtr> mArgs;
-    /// A name->argument mapping
-    Map<String, ArgDefPtr> mArgsMap;
-    /// The final argument, if configured. NULL otherwise
-    ArgDefPtr mArgFinal = NULL;
-    /// True if the parser is configured with a final argument. Same as 'mArgFinal != null'
-    bool mHasFinalArg = false;
-    /// The character to split arguments by if possible. e.g. --config=./theConfig.cfg
-    String mArgSplitChar = "=";
+/// @brief Why a value couldn't be converted to a number
+enum class ConvertError {
+    None,
+    Empty,      ///< There is no value
+    Invalid,    ///< It doesn't start with a number, or is a floating point value over detail::MaxDoubleLength long
+    Trailing,   ///< It starts with a number, but has something else after it. e.g. "12abc"
+    OutOfRange  ///< The number doesn't fit in the type
+};
+
+/// Number parsing for ArgPair. Allocation-free, and independent of the locale
+namespace detail {
+    /// @brief Parse the decimal digits at pStr[pPos] onward, leaving pPos after them
+    inline ConvertError ParseDigits(StringView pStr, size_t &pPos, uint64_t &pOut) {
+        size_t start = pPos;
+        uint64_t value = 0;
+        for(; pPos < pStr.length() && pStr[pPos] >= '0' && pStr[pPos] <= '9'; pPos++) {
+            unsigned digit = pStr[pPos] - '0';
+            if(value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+                return ConvertError::OutOfRange;
+            }
+            value = value * 10 + digit;
+        }
+        if(pPos == start) {
+            return ConvertError::Invalid;
+        }
+        pOut = value;
+        return ConvertError::None;
+    }
+
+    /**
+     * @brief Parse an optionally signed decimal integer
+     * @param pSizeSuffix Allow a K, M, G, T or P suffix (either case), multiplying by that power of 1024
+     */
+    inline ConvertError ParseInteger(StringView pStr, bool pSizeSuffix, bool &pNegative, uint64_t &pMagnitude) {
+        if(pStr.empty()) return ConvertError::Empty;
+        size_t pos = 0;
+        pNegative = pStr[0] == '-';
+        if(pStr[0] == '-' || pStr[0] == '+') pos++;
+        ConvertError error = ParseDigits(pStr, pos, pMagnitude);
+        if(error != ConvertError::None) return error;
+        if(pSizeSuffix && pos < pStr.length()) {
+            static const char SizeSuffixes[] = "KMGTP";
+            // Upper-cased. ' ' becomes '\0' too, which strchr would find at the end of SizeSuffixes
+            char upper = (char)(pStr[pos] & ~0x20);
+            const char* suffix = upper != '\0' ? strchr(SizeSuffixes, upper) : NULL;
+            if(suffix != NULL) {
+                unsigned shift = 10 * (unsigned)(suffix - SizeSuffixes + 1);
+                if(pMagnitude > (std::numeric_limits<uint64_t>::max() >> shift)) {
+                    return ConvertError::OutOfRange;
+                }
+                pMagnitude <<= shift;
+                pos++;
+            }
+        }
+        return pos == pStr.length() ? ConvertError::None : ConvertError::Trailing;
+    }
+
+    /// The longest value ParseDouble converts. Longer ones are Invalid, rather than copied to the heap for strtod
+    static const size_t MaxDoubleLength = 127;
+
+    /**
+     * @brief Convert a plain decimal, e.g. "-12.5" or "3e8", without strtod. Only when it has at most 15
+     * digits and a power of ten up to 10^22, which are exact as doubles, so one multiply or divide rounds
+     * it correctly
+     * @return False if it isn't one of those, for strtod to convert
+     */
+    inline bool ParseSimpleDouble(StringView pStr, double &pOut) {
+        static const double PowersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        size_t pos = pStr[0] == '-' || pStr[0] == '+' ? 1 : 0;
+        uint64_t mantissa = 0;
+        size_t digits = 0;
+        int exponent = 0;
+        for(; pos < pStr.length() && pStr[pos] >= '0' && pStr[pos] <= '9'; pos++, digits++) {
+            mantissa = mantissa * 10 + (unsigned)(pStr[pos] - '0');
+        }
+        if(pos < pStr.length() && pStr[pos] == '.') {
+            for(pos++; pos < pStr.length() && pStr[pos] >= '0' && pStr[pos] <= '9'; pos++, digits++, exponent--) {
+                mantissa = mantissa * 10 + (unsigned)(pStr[pos] - '0');
+            }
+        }
+        if(digits == 0 || digits > 15) {
+            return false;
+        }
+        if(pos < pStr.length() && (pStr[pos] == 'e' || pStr[pos] == 'E')) {
+            uint64_t power;
+            bool negative;
+            // A power of more than 3 digits is out of reach anyway
+            if(pStr.length() - pos > 5 || ParseInteger(pStr.substr(pos + 1), false, negative, power) != ConvertError::None) {
+                return false;
+            }
+            exponent += negative ? -(int)power : (int)power;
+            pos = pStr.length();
+        }
+        if(pos != pStr.length() || exponent < -22 || exponent > 22) {
+            return false;
+        }
+        double value = exponent < 0 ? (double)mantissa / PowersOf10[-exponent] : (double)mantissa * PowersOf10[exponent];
+        pOut = pStr[0] == '-' ? -value : value;
+        return true;
+    }
+
+    /// @brief Parse a floating point number. Always with '.' as the decimal point, whatever the locale
+    inline ConvertError ParseDouble(StringView pStr, double &pOut) {
+        if(pStr.empty()) return ConvertError::Empty;
+        // strtod skips leading spaces. Don't
+        if(!(pStr[0] == '-' || pStr[0] == '+' || pStr[0] == '.' || (pStr[0] >= '0' && pStr[0] <= '9') || isalpha((unsigned char)pStr[0]))) {
+            return ConvertError::Invalid;
+        }
+        if(ParseSimpleDouble(pStr, pOut)) {
+            return ConvertError::None;
+        }
+        if(pStr.length() > MaxDoubleLength) {
+            return ConvertError::Invalid;
+        }
+        // strtod uses the locale's decimal point, which may be more than one byte. Its own is not a
+        // decimal point here, e.g. "1,5" in a German locale, so it's trailing as it would be in the C locale
+        StringView point = localeconv()->decimal_point;
+        if(point.empty()) {
+            point = ".";
+        }
+        size_t stop = pStr.length();
+        if(point != ".") {
+            for(size_t i = 0; i < pStr.length() && stop == pStr.length(); i++) {
+                stop = pStr.substr(i).startsWith(point) ? i : stop;
+            }
+        }
+        // strtod needs a terminated string, so copy it onto the stack, with the locale's point for '.'
+        char buffer[MaxDoubleLength + 1];
+        size_t length = 0;
+        for(size_t i = 0; i < stop; i++) {
+            StringView part = pStr[i] == '.' ? point : pStr.substr(i, 1);
+            if(length + part.length() > MaxDoubleLength) {
+                return ConvertError::Invalid;
+            }
+            memcpy(buffer + length, part.data(), part.length());
+            length += part.length();
+        }
+        buffer[length] = '\0';
+        char* end;
+        errno = 0;
+        double value = strtod(buffer, &end);
+        if(end == buffer) return ConvertError::Invalid;
+        // Whatever came before the locale's point was a number
+        if(stop != pStr.length()) return ConvertError::Trailing;
+        if(errno == ERANGE && (value == HUGE_VAL || value == -HUGE_VAL)) return ConvertError::OutOfRange;
+        if(end != buffer + length) return ConvertError::Trailing;
+        pOut = value;
+        return ConvertError::None;
+    }
+}
+
+/// Constraints on values, checked while parsing. See ArgDef::withChoices etc.
+namespace detail {
+    /**
+     * @brief Match one character of a glob at pPattern against c. Sets pNext to the pattern after it.
+     * '?' is any character, '[a-z_]' a class ('[!...]' or '[^...]' for not), and '\\' escapes
+     */
+    inline bool GlobMatchOne(const char* pPattern, const char* pEnd, char c, const char* &pNext) {
+        if(*pPattern == '?') {
+            pNext = pPattern + 1;
+            return true;
+        }
+        if(*pPattern == '\\' && pPattern + 1 != pEnd) {
+            pNext = pPattern + 2;
+            return pPattern[1] == c;
+        }
+        if(*pPattern == '[') {
+            const char* pos = pPattern + 1;
+            bool negate = pos != pEnd && (*pos == '!' || *pos == '^');
+            pos += negate ? 1 : 0;
+            bool isMatch = false;
+            // A ']' straight after the '[' is part of the class
+            for(const char* first = pos; pos != pEnd && (*pos != ']' || pos == first); pos++) {
+                if(pos + 2 < pEnd && pos[1] == '-' && pos[2] != ']') {
+                    isMatch = isMatch || (c >= pos[0] && c <= pos[2]);
+                    pos += 2;
+                } else {
+                    isMatch = isMatch || c == *pos;
+                }
+            }
+            if(pos != pEnd) {
+                pNext = pos + 1;
+                return isMatch != negate;
+            }
+            // No ']', so the '[' is just a character
+        }
+        pNext = pPattern + 1;
+        return *pPattern == c;
+    }
+
+    /**
+     * @brief True if the whole of pText matches the glob pPattern: '*' is any run of characters.
+     * See GlobMatchOne for the rest. Backtracks only to the last '*', so it's linear for most patterns
+     */
+    inline bool GlobMatch(StringView pPattern, StringView pText) {
+        const char* pattern = pPattern.begin();
+        const char* text = pText.begin();
+        const char* starPattern = NULL;
+        const char* starText = NULL;
+        const char* next = NULL;
+        while(text != pText.end()) {
+            if(pattern != pPattern.end() && *pattern == '*') {
+                starPattern = ++pattern;
+                starText = text;
+            } else if(pattern != pPattern.end() && GlobMatchOne(pattern, pPattern.end(), *text, next)) {
+                pattern = next;
+                text++;
+            } else if(starPattern != NULL) {
+                // Let the last '*' take one more character
+                pattern = starPattern;
+                text = ++starText;
+            } else {
+                return false;
+            }
+        }
+        while(pattern != pPattern.end() && *pattern == '*') {
+            pattern++;
+        }
+        return pattern == pPattern.end();
+    }
+
+    /**
+     * @brief A set of choices, mapped to their indexes by a perfect hash, so finding one is a hash and
+     * a single comparison. Built by hash-and-displace (CHD): the choices are hashed into small groups,
+     * and each group, largest first, gets a seed that puts its choices in buckets still free. The seed
+     * search is capped. Should it fail, e.g. for choices whose hashes collide, an ArgIndex is used instead
+     */
+    class ChoiceSet {
+        /// Each bucket's choice and its index. -1 for an empty bucket
+        Vector<std::pair<StringView, int32_t>> mBuckets;
+        /// Each group's seed
+        Vector<uint32_t> mSeeds;
+        uint32_t mMask = 0;
+        uint32_t mGroupMask = 0;
+        /// Used instead of the perfect hash if one couldn't be found
+        ArgIndex mFallback;
+
+        /// Tries for each group's seed, before starting again with more buckets
+        static const uint32_t MaxSeedTries = 1 << 12;
+        /// Times to start again with twice the buckets, before falling back to mFallback
+        static const int MaxRebuilds = 3;
+
+        /// @brief FNV-1a, finished with a mix so both halves can be used
+        static uint64_t Hash(StringView pValue) {
+            uint64_t hash = 14695981039346656037ull;
+            for(char c : pValue) {
+                hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+            }
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdull;
+            return hash ^ (hash >> 33);
+        }
+        /// @brief The group is from the high half of the hash
+        uint32_t group(uint64_t pHash) const {
+            return (uint32_t)(pHash >> 32) & this->mGroupMask;
+        }
+        /// @brief The bucket is from the low half, displaced by the group's seed
+        uint32_t bucket(uint64_t pHash, uint32_t pSeed) const {
+            uint32_t hash = (uint32_t)pHash ^ (pSeed * 0x9E3779B9u);
+            hash ^= hash >> 16;
+            hash *= 0x85ebca6bu;
+            return (hash ^ (hash >> 13)) & this->mMask;
+        }
+
+        /// @brief Find a seed for each group. False if one runs out of tries
+        bool place(const Vector<std::pair<StringView, uint64_t>> &pChoices, size_t pSize) {
+            MemoryResource* resource = this->mBuckets.get_allocator().mResource;
+            this->mBuckets.assign(pSize, std::make_pair(StringView(), -1));
+            this->mMask = (uint32_t)(pSize - 1);
+            this->mSeeds.assign(this->mGroupMask + 1, 0);
+            // The choices by group, as indexes into pChoices, with each group's start in groupStart
+            Vector<uint32_t> groupStart(this->mGroupMask + 2, 0, resource);
+            for(const std::pair<StringView, uint64_t> &choice : pChoices) {
+                groupStart[this->group(choice.second) + 1]++;
+            }
+            for(size_t g = 1; g < groupStart.size(); g++) {
+                groupStart[g] += groupStart[g - 1];
+            }
+            Vector<uint32_t> members(pChoices.size(), 0, resource);
+            Vector<uint32_t> fill(groupStart.begin(), groupStart.end() - 1, resource);
+            for(uint32_t i = 0; i < pChoices.size(); i++) {
+                members[fill[this->group(pChoices[i].second)]++] = i;
+            }
+            Vector<uint32_t> order(this->mGroupMask + 1, 0, resource);
+            for(uint32_t g = 0; g < order.size(); g++) {
+                order[g] = g;
+            }
+            std::sort(order.begin(), order.end(), [&groupStart](uint32_t a, uint32_t b) {
+                return groupStart[a + 1] - groupStart[a] > groupStart[b + 1] - groupStart[b];
+            });
+
+            Vector<uint32_t> taken(resource);
+            for(uint32_t g : order) {
+                const uint32_t* begin = members.data() + groupStart[g];
+                const uint32_t* end = members.data() + groupStart[g + 1];
+                if(begin == end) {
+                    break; // Sorted largest first, so the rest are empty
+                }
+                bool isPlaced = false;
+                for(uint32_t seed = 0; seed < MaxSeedTries && !isPlaced; seed++) {
+                    taken.clear();
+                    isPlaced = true;
+                    for(const uint32_t* member = begin; member != end; member++) {
+                        uint32_t at = this->bucket(pChoices[*member].second, seed);
+                        if(this->mBuckets[at].second >= 0 || std::find(taken.begin(), taken.end(), at) != taken.end()) {
+                            isPlaced = false;
+                            break;
+                        }
+                        taken.push_back(at);
+                    }
+                    if(isPlaced) {
+                        this->mSeeds[g] = seed;
+                        for(size_t i = 0; i < taken.size(); i++) {
+                            this->mBuckets[taken[i]] = std::make_pair(pChoices[begin[i]].first, (int32_t)begin[i]);
+                        }
+                    }
+                }
+                if(!isPlaced) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    public:
+        explicit ChoiceSet(MemoryResource* pResource=DefaultResource())
+            : mBuckets(pResource), mSeeds(pResource), mFallback(pResource) {}
+
+        /**
+         * @brief Find a perfect hash for the choices
+         * @param pCSChoices Comma-separated. Must outlive the set
+         * @throw std::invalid_argument If a choice is repeated
+         */
+        void build(StringView pCSChoices) {
+            MemoryResource* resource = this->mBuckets.get_allocator().mResource;
+            Vector<std::pair<StringView, uint64_t>> choices(resource);
+            for(StringView choice : CsvRange(pCSChoices)) {
+                choices.push_back(std::make_pair(choice, Hash(choice)));
+            }
+            // Repeats share a hash, so sorting by it puts them next to each other
+            Vector<std::pair<StringView, uint64_t>> sorted(choices.begin(), choices.end(), resource);
+            std::sort(sorted.begin(), sorted.end(), [](const std::pair<StringView, uint64_t> &a, const std::pair<StringView, uint64_t> &b) {
+                return a.second < b.second;
+            });
+            for(size_t i = 1; i < sorted.size(); i++) {
+                for(size_t j = i; j > 0 && sorted[j - 1].second == sorted[i].second; j--) {
+                    if(sorted[j - 1].first == sorted[i].first) {
+                        throw std::invalid_argument("Repeated choice: " + sorted[i].first.toString());
+                    }
+                }
+            }
+
+            this->mFallback = ArgIndex(resource);
+            // About four choices to a group, and half the buckets free
+            size_t groups = 1;
+            while(groups * 4 < choices.size()) {
+                groups *= 2;
+            }
+            this->mGroupMask = (uint32_t)(groups - 1);
+            size_t size = 4;
+            while(size < choices.size() * 2) {
+                size *= 2;
+            }
+            for(int attempt = 0; attempt <= MaxRebuilds; attempt++, size *= 2) {
+                if(this->place(choices, size)) {
+                    return;
+                }
+            }
+            this->mBuckets.clear();
+            this->mSeeds.clear();
+            for(size_t i = 0; i < choices.size(); i++) {
+                this->mFallback.insert(choices[i].first, (uint32_t)i);
+            }
+        }
+
+        /// @brief The index of the choice, or -1 if it isn't one
+        int32_t find(StringView pValue) const {
+            if(this->mBuckets.empty()) {
+                uint32_t index = this->mFallback.find(pValue);
+                return index == ArgIndex::npos ? -1 : (int32_t)index;
+            }
+            uint64_t hash = Hash(pValue);
+            const std::pair<StringView, int32_t> &bucket = this->mBuckets[this->bucket(hash, this->mSeeds[this->group(hash)])];
+            return bucket.second >= 0 && bucket.first == pValue ? bucket.second : -1;
+        }
+
+        /// @brief The memory the tables take
+        size_t bytes() const {
+            return this->mBuckets.capacity() * sizeof(this->mBuckets[0]) + this->mSeeds.capacity() * sizeof(uint32_t)
+                + this->mFallback.bytes();
+        }
+    };
+
+    /// @brief An argument's constraints, ready to check values against. See ArgParser::setChoices etc.
+    struct Constraint {
+        /// The comma-separated choices, or empty for any value
+        StringView mChoicesText;
+        ChoiceSet mChoices;
+        /// The glob to match, or empty for any value
+        StringView mPattern;
+        bool mHasRange = false;
+        double mMin = 0;
+        double mMax = 0;
+
+        explicit Constraint(MemoryResource* pResource=DefaultResource()) : mChoices(pResource) {}
+
+        bool isSet() const {
+            return !this->mChoicesText.empty() || !this->mPattern.empty() || this->mHasRange;
+        }
+
+        /**
+         * @brief Check the value
+         * @param pChoice Set to the index of the choice it is, or -1 if there are no choices
+         */
+        ConvertError check(StringView pValue, int32_t &pChoice) const {
+            pChoice = -1;
+            if(!this->mChoicesText.empty()) {
+                pChoice = this->mChoices.find(pValue);
+                if(pChoice < 0) return ConvertError::Invalid;
+            }
+            if(this->mHasRange) {
+                double value;
+                ConvertError error = ParseDouble(pValue, value);
+                if(error != ConvertError::None) return error;
+                if(value < this->mMin || value > this->mMax) return ConvertError::OutOfRange;
+            }
+            if(!this->mPattern.empty() && !GlobMatch(this->mPattern, pValue)) {
+                return ConvertError::Invalid;
+            }
+            return ConvertError::None;
+        }
+    };
+}
+
+struct ArgPair {
+    ArgDefPtr mArg = NULL;
+    /// View of the value. Points into argv (zero-copy mode) or the result's own copy of argv
+    StringView mValue;
+    /// If the argument has choices (see ArgDef::withChoices), the index of the one given. -1 otherwise,
+    /// or if it's missing. e.g. switch(argParser["--mode"].mChoice) { case 0: ... }
+    int32_t mChoice = -1;
+
+private:
+    ConvertError convertSigned(int64_t &pOut) const {
+        bool negative;
+        uint64_t magnitude;
+        ConvertError error = detail::ParseInteger(this->mValue, false, negative, magnitude);
+        if(error != ConvertError::None) return error;
+        uint64_t limit = (uint64_t)std::numeric_limits<int64_t>::max() + (negative ? 1 : 0);
+        if(magnitude > limit) return ConvertError::OutOfRange;
+        pOut = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+        return ConvertError::None;
+    }
+
+    ConvertError convertUnsigned(uint64_t &pOut, bool pSizeSuffix) const {
+        bool negative;
+        uint64_t magnitude;
+        ConvertError error = detail::ParseInteger(this->mValue, pSizeSuffix, negative, magnitude);
+        if(error != ConvertError::None) return error;
+        if(negative && magnitude != 0) return ConvertError::OutOfRange;
+        pOut = magnitude;
+        return ConvertError::None;
+    }
+
+    ConvertError convertFloating(double &pOut) const {
+        return detail::ParseDouble(this->mValue, pOut);
+    }
+
+    template<typename T>
+    ConvertError convert(T &pOut, std::integral_constant<int, 0>) const { // Unsigned
+        uint64_t value;
+        ConvertError error = this->convertUnsigned(value, false);
+        if(error != ConvertError::None) return error;
+        if(value > (uint64_t)std::numeric_limits<T>::max()) return ConvertError::OutOfRange;
+        pOut = (T)value;
+        return ConvertError::None;
+    }
+
+    template<typename T>
+    ConvertError convert(T &pOut, std::integral_constant<int, 1>) const { // Signed
+        int64_t value;
+        ConvertError error = this->convertSigned(value);
+        if(error != ConvertError::None) return error;
+        if(value < (int64_t)std::numeric_limits<T>::min() || value > (int64_t)std::numeric_limits<T>::max()) {
+            return ConvertError::OutOfRange;
+        }
+        pOut = (T)value;
+        return ConvertError::None;
+    }
+
+    template<typename T>
+    ConvertError convert(T &pOut, std::integral_constant<int, 2>) const { // Floating point
+        double value;
+        ConvertError error = this->convertFloating(value);
+        if(error != ConvertError::None) return error;
+        if(isfinite(value) && fabs(value) > (double)std::numeric_limits<T>::max()) return ConvertError::OutOfRange;
+        pOut = (T)value;
+        return ConvertError::None;
+    }
+
+    /// @brief Convert, throwing std::invalid_argument or std::out_of_range (like std::stoi) if it can't be
+    template<typename T>
+    T asNumber(T pDefault) const {
+        T value;
+        switch(this->to(value)) {
+            case ConvertError::None: return value;
+            case ConvertError::Empty: return pDefault;
+            case ConvertError::OutOfRange: throw std::out_of_range("Value out of range: " + this->mValue.toString());
+            case ConvertError::Trailing: throw std::invalid_argument("Unexpected characters after the number: " + this->mValue.toString());
+            default: throw std::invalid_argument("Not a number: " + this->mValue.toString());
+        }
+    }
+
+    template<typename T>
+    static ConvertError ConvertElement(StringView pElement, T &pOut) {
+        ArgPair element;
+        element.mValue = pElement;
+        return element.to(pOut);
+    }
+
+    static ConvertError ConvertElement(StringView pElement, StringView &pOut) {
+        pOut = pElement;
+        return ConvertError::None;
+    }
+
+    /// @brief Convert a list, throwing std::invalid_argument or std::out_of_range naming the element at fault
+    template<typename T>
+    Vector<T> asList(char pDelimiter) const {
+        Vector<T> values;
+        size_t index = 0;
+        ConvertError error = this->toList(values, pDelimiter, &index);
+        if(error == ConvertError::None) {
+            return values;
+        }
+        // Find the element again for the message. Only on failure, so the list is never split into strings
+        StringView element = this->mValue;
+        for(size_t i = 0; i <= index; i++) {
+            size_t end = element.find_first_of(StringView(&pDelimiter, 1));
+            if(i == index) {
+                element = element.substr(0, end);
+            } else {
+                element = element.substr(end + 1);
+            }
+        }
+        String message = "list element " + std::to_string(index) + ": " + element.toString();
+        if(error == ConvertError::OutOfRange) {
+            throw std::out_of_range("Value out of range in " + message);
+        }
+        throw std::invalid_argument("Invalid " + message);
+    }
+
+public:
+    /**
+     * @brief Convert the value to any integer or floating point type, without throwing or allocating.
+     * Integers are decimal, optionally signed. Floating point numbers always use '.' as the
+     * decimal point, whatever the locale. The whole value must be the number.
+     * Only reads the pair, so a result can be converted from on many threads at once.
+     * @param pOut Set to the value, only if it could be converted
+     */
+    template<typename T>
+    ConvertError to(T &pOut) const {
+        static_assert(std::is_arithmetic<T>::value, "ArgPair::to converts to numbers only");
+        return this->convert(pOut, std::integral_constant<int,
+            std::is_floating_point<T>::value ? 2 : (std::is_signed<T>::value ? 1 : 0)>());
+    }
+
+    /**
+     * @brief Convert a size, without throwing or allocating.
+     * As 'to', but may have a K, M, G, T or P suffix (either case) for that power of 1024. e.g. "64M"
+     */
+    ConvertError toSize(uint64_t &pOut) const {
+        return this->convertUnsigned(pOut, true);
+    }
+
+    String asString(String pDefault="") const {
+        if(this->mValue.length() == 0) return pDefault;
+        return this->mValue.toString();
+    }
+    StringView asStringView(StringView pDefault=StringView()) const {
+        if(this->mValue.length() == 0) return pDefault;
+        return this->mValue;
+    }
+
+    // The numeric 'as' functions return the default if there's no value, and throw
+    // std::invalid_argument or std::out_of_range if it can't be converted. See 'to' for a non-throwing version
+
+    int asInt(int pDefault=0) const { 
+        return this->asNumber(pDefault);
+    }
+    long asLong(long pDefault=0) const { 
+        return this->asNumber(pDefault);
+    }
+    int64_t asInt64(int64_t pDefault=0) const {
+        return this->asNumber(pDefault);
+    }
+    uint64_t asUInt64(uint64_t pDefault=0) const {
+        return this->asNumber(pDefault);
+    }
+    /// @brief A size, with an optional K, M, G, T or P suffix. See toSize
+    uint64_t asSize(uint64_t pDefault=0) const {
+        uint64_t value;
+        switch(this->toSize(value)) {
+            case ConvertError::None: return value;
+            case ConvertError::Empty: return pDefault;
+            case ConvertError::OutOfRange: throw std::out_of_range("Value out of range: " + this->mValue.toString());
+            default: throw std::invalid_argument("Not a size: " + this->mValue.toString());
+        }
+    }
+    float asFloat(float pDefault=0) const { 
+        return this->asNumber(pDefault);
+    }
+    double asDouble(double pDefault=0) const { 
+        return this->asNumber(pDefault);
+    }
+    bool asBool(bool pDefault=false) const { 
+        if(this->mValue.length() == 0) return pDefault;
+        return this->mValue == "true" || this->mValue == "yes";
+    }
+
+    /**
+     * @brief Convert a delimited list, e.g. "1,5,9", into pOut without throwing.
+     * Elements are numbers converted as 'to', or StringViews of the value. An empty value is an
+     * empty list. The delimiters are counted first so pOut is allocated once.
+     * @param pOut Cleared, then filled. On failure, holds the elements before the one at fault
+     * @param pErrorIndex If not NULL, set to the index of the element at fault on failure
+     */
+    template<typename T, typename A>
+    ConvertError toList(std::vector<T, A> &pOut, char pDelimiter=',', size_t* pErrorIndex=NULL) const {
+        pOut.clear();
+        if(this->mValue.empty()) {
+            return ConvertError::None;
+        }
+        const char* end = this->mValue.data() + this->mValue.length();
+        // A branch-free count, which compilers vectorise
+        size_t count = 1 + std::count(this->mValue.data(), end, pDelimiter);
+        pOut.reserve(count);
+        const char* start = this->mValue.data();
+        for(size_t i = 0; i < count; i++) {
+            // Elements are short, so a plain scan beats calling memchr
+            const char* stop = start;
+            while(stop != end && *stop != pDelimiter) {
+                stop++;
+            }
+            T value;
+            ConvertError error = ConvertElement(StringView(start, stop - start), value);
+            if(error != ConvertError::None) {
+                if(pErrorIndex != NULL) {
+                    *pErrorIndex = i;
+                }
+                return error;
+            }
+            pOut.push_back(value);
+            start = stop + 1;
+        }
+        return ConvertError::None;
+    }
+
+    // The list 'as' functions throw std::invalid_argument or std::out_of_range, naming the element at fault.
+    // See toList for a non-throwing version
+
+    Vector<int> asIntList(char pDelimiter=',') const {
+        return this->asList<int>(pDelimiter);
+    }
+    Vector<int64_t> asInt64List(char pDelimiter=',') const {
+        return this->asList<int64_t>(pDelimiter);
+    }
+    Vector<double> asDoubleList(char pDelimiter=',') const {
+        return this->asList<double>(pDelimiter);
+    }
+    /// @brief Views of the elements. Valid as long as the value is
+    Vector<StringView> asStringViewList(char pDelimiter=',') const {
+        return this->asList<StringView>(pDelimiter);
+    }
+};
+
+/// Suggesting arguments for misspelt ones
+namespace detail {
+    /**
+     * @brief Edit (Levenshtein) distances from one pattern of up to 64 characters. Myers' bit-parallel
+     * algorithm, in Hyyro's formulation: a whole column of the distance table is a 64-bit word, so
+     * each character of the text costs a handful of word operations.
+     */
+    class EditDistance {
+        /// For each character, the positions it's at in the pattern as bits
+        uint64_t mPeq[256];
+        size_t mLength;
+        /// The CharBits of the pattern
+        uint64_t mChars;
+
+        /// @brief Which of 64 kinds a character is: a letter of either case, a digit, or anything else by its value
+        static unsigned CharKind(char c) {
+            unsigned char lower = (unsigned char)c | 0x20;
+            if(lower >= 'a' && lower <= 'z') {
+                return lower - 'a';
+            }
+            if(c >= '0' && c <= '9') {
+                return 26 + (c - '0');
+            }
+            return 36 + (unsigned char)c % 28;
+        }
+        static size_t PopCount(uint64_t pBits) {
+            pBits = pBits - ((pBits >> 1) & 0x5555555555555555ull);
+            pBits = (pBits & 0x3333333333333333ull) + ((pBits >> 2) & 0x3333333333333333ull);
+            pBits = (pBits + (pBits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+            return (size_t)((pBits * 0x0101010101010101ull) >> 56);
+        }
+    public:
+        static const size_t MaxLength = 64;
+
+        /// @param pPattern At most MaxLength characters. Any more are ignored
+        explicit EditDistance(StringView pPattern)
+            : mLength(pPattern.length() < MaxLength ? pPattern.length() : (size_t)MaxLength) {
+            memset(this->mPeq, 0, sizeof(this->mPeq));
+            for(size_t i = 0; i < this->mLength; i++) {
+                this->mPeq[(unsigned char)pPattern[i]] |= 1ull << i;
+            }
+            this->mChars = CharBits(pPattern.substr(0, this->mLength));
+        }
+
+        /// @brief A bit for each CharKind in pText. Candidates keep theirs, to be filtered by lowerBound
+        static uint64_t CharBits(StringView pText) {
+            uint64_t bits = 0;
+            for(char c : pText) {
+                bits |= 1ull << CharKind(c);
+            }
+            return bits;
+        }
+
+        /**
+         * @brief True if the distance to pText is surely over pBound, without working it out: by the difference
+         * in lengths, then by the kinds of character (pTextChars, its CharBits) in only one of them. Each of
+         * those takes an edit to remove or add, and one edit can do one of each. A few word operations, where
+         * distance costs a few per character, so most candidates are ruled out before it
+         */
+        bool isOver(StringView pText, uint64_t pTextChars, size_t pBound) const {
+            size_t n = pText.length();
+            if((n > this->mLength ? n - this->mLength : this->mLength - n) > pBound) {
+                return true;
+            }
+            return PopCount(this->mChars & ~pTextChars) > pBound || PopCount(pTextChars & ~this->mChars) > pBound;
+        }
+
+        /// @brief The distance from the pattern to pText. Anything over pBound is pBound + 1
+        size_t distance(StringView pText, size_t pBound) const {
+            size_t n = pText.length();
+            if((n > this->mLength ? n - this->mLength : this->mLength - n) > pBound) {
+                return pBound + 1;
+            }
+            if(this->mLength == 0) {
+                return n;
+            }
+            uint64_t pv = ~0ull, mv = 0, last = 1ull << (this->mLength - 1);
+            size_t score = this->mLength;
+            for(size_t j = 0; j < n; j++) {
+                uint64_t eq = this->mPeq[(unsigned char)pText[j]];
+                uint64_t xv = eq | mv;
+                uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+                uint64_t ph = mv | ~(xh | pv);
+                uint64_t mh = pv & xh;
+                if(ph & last) {
+                    score++;
+                } else if(mh & last) {
+                    score--;
+                }
+                // Each character left can only take one off
+                if(score > pBound + (n - j - 1)) {
+                    return pBound + 1;
+                }
+                ph = (ph << 1) | 1;
+                mh <<= 1;
+                pv = mh | ~(xv | ph);
+                mv = ph & xv;
+            }
+            return score;
+        }
+    };
+
+    /// @brief ". Did you mean a, b or c?" for the strings in the range. Empty if it's empty
+    template<typename Iterator>
+    String DidYouMean(Iterator pBegin, Iterator pEnd) {
+        String text;
+        for(Iterator it = pBegin; it != pEnd; ++it) {
+            text += it == pBegin ? ". Did you mean " : (it + 1 == pEnd ? " or " : ", ");
+            text.append(it->data(), it->length());
+        }
+        return text.empty() ? text : text + "?";
+    }
+}
+
+class UnknownArgument : public std::exception {
+    String message, key;
+    std::vector<String> suggestions;
+public:
+    UnknownArgument(String key, std::vector<String> suggestions=std::vector<String>()) {
+        this->message = "Unknown argument: " + key + detail::DidYouMean(suggestions.begin(), suggestions.end());
+        this->key = key;
+        this->suggestions = std::move(suggestions);
+    }
+
+    const String& getKey() const {
+        return this->key;
+    }
+
+    /// @brief The known arguments closest to the key, closest first. See ParseError::mSuggestions
+    const std::vector<String>& getSuggestions() const {
+        return this->suggestions;
+    }
+
+	const char * what () const throw () {
+    	return this->message.c_str();
+    }
+};
+class MissingArgument : public std::exception {
+    String message, key;
+public:
+    MissingArgument(String key) {
+        this->message = "Missing mandatory argument: " + key;
+        this->key = key;
+    }
+
+    const String& getKey() const {
+        return this->key;
+    }
+
+	const char * what () const throw () {
+    	return this->message.c_str();
+    }
+};
+class MissingValue : public std::exception {
+    String message, key;
+public:
+    MissingValue(String key) {
+        this->message = "Found argument " + key + " with no value";
+        this->key = key;
+    }
+
+    const String& getKey() const {
+        return this->key;
+    }
+
+	const char * what () const throw () {
+    	return this->message.c_str();
+    }
+};
+
+class InvalidValue : public std::exception {
+    String message, key, value;
+public:
+    InvalidValue(String key, String value) {
+        this->message = "Invalid value " + value + " for argument " + key;
+        this->key = key;
+        this->value = value;
+    }
+
+    const String& getKey() const {
+        return this->key;
+    }
+
+    const String& getValue() const {
+        return this->value;
+    }
+
+	const char * what () const throw () {
+    	return this->message.c_str();
+    }
+};
+
+/// @brief The kinds of error a parse can fail with
+enum class ErrorKind {
+    None,
+    UnknownArgument,    ///< See UnknownArgument
+    MissingArgument,    ///< See MissingArgument
+    MissingValue,       ///< See MissingValue
+    UnterminatedQuote,  ///< A quote in a command line was never closed
+    InvalidValue,       ///< See InvalidValue. A value couldn't be stored in its bound variable
+    ResponseFile,       ///< A response file (@path) couldn't be read
+    ResponseFileCycle,  ///< A response file includes itself, directly or not
+    Completed           ///< Not a failure: argv asked for completions, which were printed instead. See ArgParser::setCompletion
+};
+
+/**
+ * @brief Why a parse failed, as a value rather than an exception.
+ * Cheap to create: it only refers to the tokens and definitions, which must outlive it,
+ * and a message is only built if asked for.
+ */
+struct ParseError {
+    /// Used for mTokenIndex when the error isn't in any one token
+    static const size_t npos = (size_t)-1;
+
+    ErrorKind mKind = ErrorKind::None;
+    /// The argument at fault. Points into the tokens, or the argument definitions.
+    /// For the response file errors, and UnterminatedQuote in a response file, the file's path
+    StringView mKey;
+    /// The index of the token at fault (argv[0] being 0), or npos. e.g. none for MissingArgument
+    size_t mTokenIndex = npos;
+    /// Where in that token the error was found. For UnterminatedQuote, the offset of the quote in the line
+    /// or response file
+    size_t mPosition = 0;
+    /// For InvalidValue, the value at fault, and why
+    StringView mValue;
+    ConvertError mConvertError = ConvertError::None;
+    /// For UnknownArgument, the known names, aliases and subcommands closest to the key, closest first.
+    /// Views of the definitions
+    static const size_t MaxSuggestions = 3;
+    StringView mSuggestions[MaxSuggestions];
+    size_t mSuggestionCount = 0;
+
+    explicit operator bool() const { return this->mKind != ErrorKind::None; }
+
+    /// @brief Describe the error. The same text as the exception's 'what'
+    String message() const {
+        switch(this->mKind) {
+            case ErrorKind::UnknownArgument:
+                return "Unknown argument: " + this->mKey.toString() +
+                    detail::DidYouMean(this->mSuggestions, this->mSuggestions + this->mSuggestionCount);
+            case ErrorKind::MissingArgument: return "Missing mandatory argument: " + this->mKey.toString();
+            case ErrorKind::MissingValue: return "Found argument " + this->mKey.toString() + " with no value";
+            case ErrorKind::UnterminatedQuote:
+                return this->mKey.empty() ? "Unterminated quote" : "Unterminated quote in " + this->mKey.toString();
+            case ErrorKind::ResponseFile: return "Can't read response file: " + this->mKey.toString();
+            case ErrorKind::ResponseFileCycle: return "Response file includes itself: " + this->mKey.toString();
+            case ErrorKind::InvalidValue: return "Invalid value " + this->mValue.toString() + " for argument " + this->mKey.toString();
+            case ErrorKind::Completed: return "Printed completions instead of parsing";
+            default: return "";
+        }
+    }
+
+    /**
+     * @brief Throw the exception matching this error. Does nothing if there's no error, or it's Completed
+     * @throw UnknownArgument, MissingArgument, MissingValue, InvalidValue, std::runtime_error
+     */
+    void raise() const {
+        switch(this->mKind) {
+            case ErrorKind::UnknownArgument: {
+                std::vector<String> suggestions;
+                for(size_t i = 0; i < this->mSuggestionCount; i++) {
+                    suggestions.push_back(this->mSuggestions[i].toString());
+                }
+                throw UnknownArgument(this->mKey.toString(), std::move(suggestions));
+            }
+            case ErrorKind::MissingArgument: throw MissingArgument(this->mKey.toString());
+            case ErrorKind::MissingValue: throw MissingValue(this->mKey.toString());
+            case ErrorKind::UnterminatedQuote:
+            case ErrorKind::ResponseFile:
+            case ErrorKind::ResponseFileCycle: throw std::runtime_error(this->message());
+            case ErrorKind::InvalidValue: throw InvalidValue(this->mKey.toString(), this->mValue.toString());
+            default: return;
+        }
+    }
+};
+
+/**
+ * @brief The values of an argument, contiguous in the result. e.g.
+ *   for(argparse::StringView input : result.getAll("--input")) { ... }
+ */
+struct ArgValues {
+    const StringView* mBegin = NULL;
+    const StringView* mEnd = NULL;
+
+    const StringView* begin() const { return this->mBegin; }
+    const StringView* end() const { return this->mEnd; }
+    size_t size() const { return (size_t)(this->mEnd - this->mBegin); }
+    bool empty() const { return this->mBegin == this->mEnd; }
+    const StringView& operator[](size_t pIndex) const { return this->mBegin[pIndex]; }
+
+    /// @brief Up to pCount values from pOffset on. e.g. to split them between threads
+    ArgValues slice(size_t pOffset, size_t pCount) const {
+        ArgValues values;
+        values.mBegin = this->mBegin + std::min(pOffset, this->size());
+        values.mEnd = values.mBegin + std::min(pCount, (size_t)(this->mEnd - values.mBegin));
+        return values;
+    }
+
+    /// @brief The pIndex'th of pChunkCount near-equal parts. Together the parts cover all the values, in order
+    ArgValues chunk(size_t pIndex, size_t pChunkCount) const {
+        size_t begin = this->size() * pIndex / pChunkCount;
+        size_t end = this->size() * (pIndex + 1) / pChunkCount;
+        return this->slice(begin, end - begin);
+    }
+};
+
+/**
+ * @brief Counts and timings for a parse, to see what it costs. Only filled in if the library is
+ * compiled with CPP_ARG_PARSER_STATS defined. Otherwise all zero, and nothing is counted.
+ * The phases overlap: conversion happens within lookup and validation
+ */
+struct ParseStats {
+    uint64_t mTotalNs = 0;
+    /// Copying argv and expanding response files
+    uint64_t mTokenizeNs = 0;
+    /// Matching the tokens to arguments
+    uint64_t mLookupNs = 0;
+    /// Filling in values from other sources, checking for missing arguments, and defaulting
+    uint64_t mValidateNs = 0;
+    /// Converting values for bound variables, and storing them
+    uint64_t mConvertNs = 0;
+    /// Allocations through the parser's MemoryResource on the parsing thread. Not std::string's
+    size_t mAllocations = 0;
+    size_t mAllocatedBytes = 0;
+    size_t mTokens = 0;
+    /// Names looked up in the index, and how many weren't found
+    size_t mLookups = 0;
+    size_t mLookupMisses = 0;
+};
+
+/**
+ * @brief Told about each parse, e.g. to log slow ones. See ArgParser::setParseObserver.
+ * Only called if the library is compiled with CPP_ARG_PARSER_STATS defined
+ */
+class ParseObserver {
+public:
+    virtual ~ParseObserver() {}
+    /// @brief Called at the end of each parse (but not a bulk parse), on the thread that parsed
+    virtual void onParse(const ParseStats &pStats, const ParseError &pError) = 0;
+};
+
+struct ArgParserResult {
+    /// A result per argument, indexed by the argument's slot: its position in the parser's
+    /// argument list, with the final argument (if any) last
+    Vector<ArgPair> mSlots;
+    /// Whether each slot's argument was found in argv
+    Vector<bool> mSeen;
+    /// The values of all the repeatable arguments, grouped by slot, in argv order within each
+    Vector<StringView> mValues;
+    /// Where each slot's values start in mValues, and (at [slot + 1]) end. Empty if none are repeatable
+    Vector<uint32_t> mValueOffsets;
+    /// The occurrences of repeatable arguments in argv order, until they're grouped into mValues
+    Vector<std::pair<uint32_t, StringView>> mOccurrences;
+    /// The positional arguments, in argv order. See ArgParser::setPositionals
+    Vector<StringView> mPositionals;
+    /// A value of a bound argument, stored in its variable once the parse succeeds. See ArgParser::bind
+    struct BoundValue {
+        StringView mValue;
+        uint64_t mConverted;    ///< The value converted, if it's a number or bool. See ArgBinding
+        uint32_t mSlot;
+        bool mFirst;            ///< The argument's first occurrence in the parse
+    };
+    /// The values of bound arguments, in the order found. Checked, but not stored until the parse succeeds
+    Vector<BoundValue> mBoundValues;
+    /// The parser's own copy of argv, when not in zero-copy mode. All value views point in here
+    Vector<char> mStorage;
+    /// The tokens that were parsed. Point into mStorage, or the caller's argv in zero-copy mode,
+    /// or mResponseFiles
+    Vector<StringView> mTokens;
+    /// The response files (@path) in argv, and any they include. Tokens from them point in here
+    Vector<MappedFile> mResponseFiles;
+    /// Where the tokens are built up while response files are expanded. Swapped with mTokens
+    Vector<StringView> mExpandedTokens;
+    /// The name index of the parser that filled this result, for looking up names. It must outlive the result
+    const ArgIndex* mIndex = NULL;
+    /// The final argument of that parser, if it has one. NULL otherwise
+    ArgDefPtr mFinalArg = NULL;
+    /// What the last parse cost, if compiled with CPP_ARG_PARSER_STATS
+    ParseStats mStats;
+    /// The name of the subcommand given, if any. See ArgParser::addSubcommand
+    StringView mSubcommand;
+    /// Where the subcommand's arguments are parsed into. Kept between parses for reuse
+    std::unique_ptr<ArgParserResult> mSubcommandResult;
+    /// If this is a subcommand's result, its parent's, which its global options go into. Only set during a parse
+    ArgParserResult* mParentResult = NULL;
+    /// True if argv asked for completions, which were printed instead of parsing. See ArgParser::setCompletion
+    bool mCompleted = false;
+    /// The environment values the result took, if any. Kept alive through ArgParser::loadEnvironment reloading them
+    std::shared_ptr<const Vector<char>> mEnvStorage;
+
+    ArgParserResult() = default;
+    /// @brief Allocate everything from the given resource, which must outlive the result
+    explicit ArgParserResult(MemoryResource* pResource)
+        : mSlots(pResource), mSeen(pResource), mValues(pResource), mValueOffsets(pResource), mOccurrences(pResource),
+          mPositionals(pResource), mBoundValues(pResource), mStorage(pResource), mTokens(pResource), mResponseFiles(pResource),
+          mExpandedTokens(pResource) {}
+    // Copying would leave the value views pointing into the original's storage
+    ArgParserResult(const ArgParserResult&) = delete;
+    ArgParserResult& operator=(const ArgParserResult&) = delete;
+    ArgParserResult(ArgParserResult&&) = default;
+    ArgParserResult& operator=(ArgParserResult&&) = default;
+
+    /**
+     * @brief Empty the slots ready for a parse. Keeps their memory for reuse
+     * @param pRepeatable True if any of the arguments are repeatable
+     */
+    void resetSlots(size_t pSlotCount, bool pRepeatable) {
+        mSlots.assign(pSlotCount, ArgPair());
+        mSeen.assign(pSlotCount, false);
+        mValues.clear();
+        mOccurrences.clear();
+        mPositionals.clear();
+        mBoundValues.clear();
+        // One spare at each end, for grouping. See groupValues
+        mValueOffsets.assign(pRepeatable ? pSlotCount + 2 : 0, 0);
+    }
+
+    /// @brief Record an occurrence of a repeatable argument, counting them per slot
+    void addOccurrence(uint32_t pSlot, StringView pValue) {
+        mOccurrences.push_back(std::make_pair(pSlot, pValue));
+        mValueOffsets[pSlot + 2]++;
+    }
+
+    /**
+     * @brief Group the occurrences by slot into mValues, now they've all been counted.
+     * A counting sort: sizes mValues once, and keeps argv order within each slot.
+     */
+    void groupValues() {
+        if(mOccurrences.empty()) {
+            return;
+        }
+        // Each slot's count is at [slot + 2]. Summed, [slot + 2] is where the next slot starts
+        for(size_t i = 2; i < mValueOffsets.size(); i++) {
+            mValueOffsets[i] += mValueOffsets[i - 1];
+        }
+        // Using [slot + 1] as each slot's cursor leaves it where the slot ends, and [slot] where it starts
+        mValues.resize(mOccurrences.size());
+        for(const std::pair<uint32_t, StringView> &occurrence : mOccurrences) {
+            mValues[mValueOffsets[occurrence.first + 1]++] = occurrence.second;
+        }
+    }
+
+    /// @brief Set the result for a slot, if it doesn't have one yet. The first occurrence wins
+    void setResult(uint32_t pSlot, ArgDefPtr pArg, StringView pValue) {
+        if(mSeen[pSlot]) return;
+        mSeen[pSlot] = true;
+        mSlots[pSlot].mArg = pArg;
+        mSlots[pSlot].mValue = pValue;
+    }
+
+    /**
+     * @brief Record the tokens to parse.
+     * Copies them all into a single buffer, unless pZeroCopy is set
+     * in which case the caller's argv is referenced directly.
+     */
+    void setArgv(int argc, char const* const* argv, bool pZeroCopy) {
+        mTokens.resize(argc > 0 ? argc : 0);
+        for(int i = 0; i < argc; i++) {
+            mTokens[i] = StringView(argv[i]);
+        }
+        if(!pZeroCopy) {
+            this->copyTokens();
+        }
+    }
+
+    /// @brief Copy the tokens into a single buffer, and point them at it
+    void copyTokens() {
+        size_t total = 0;
+        for(StringView token : mTokens) {
+            total += token.length();
+        }
+        mStorage.resize(total);
+        size_t offset = 0;
+        for(StringView &token : mTokens) {
+            if(token.length() > 0) {
+                memcpy(&mStorage[offset], token.data(), token.length());
+            }
+            token = StringView(mStorage.data() + offset, token.length());
+            offset += token.length();
+        }
+    }
+
+    /**
+     * @brief Get the argument pair given the argument name (or alias), looking it up in the given index
+     * @throw MissingArgument if the pair doesn't exist
+     */
+    const ArgPair& get(StringView key, const ArgIndex &pIndex, ArgDefPtr pFinalArg) const {
+        // The final argument is in the last slot
+        uint32_t slot = (pFinalArg != NULL && key == pFinalArg->mName) ? (uint32_t)(mSlots.size() - 1) : pIndex.find(key);
+        if(slot >= mSlots.size()) {
+            throw MissingArgument(key.toString());
+        }
+        return mSlots[slot];
+    }
+
+    /**
+     * @brief Get the argument pair given the argument name.
+     * @throw MissingArgument if the pair doesn't exist
+     */
+    const ArgPair& operator[](const char* key) const {
+        if(mIndex == NULL) {
+            throw MissingArgument(key);
+        }
+        return this->get(key, *mIndex, mFinalArg);
+    }
+
+    /**
+     * @brief Get every value of an argument given its name (or alias), looking it up in the given index.
+     * For a repeatable argument, all of its occurrences. Otherwise the one value, or none if it was missing.
+     * @throw MissingArgument if there's no such argument
+     */
+    ArgValues getAll(StringView key, const ArgIndex &pIndex, ArgDefPtr pFinalArg) const {
+        const ArgPair &pair = this->get(key, pIndex, pFinalArg);
+        return this->getSlotValues((uint32_t)(&pair - mSlots.data()));
+    }
+
+    /// @brief Every value of the argument in the slot. See getAll
+    ArgValues getSlotValues(uint32_t slot) const {
+        const ArgPair &pair = mSlots[slot];
+        ArgValues values;
+        if(pair.mArg != NULL && pair.mArg->mRepeatable) {
+            values.mBegin = mValues.data() + mValueOffsets[slot];
+            values.mEnd = mValues.data() + mValueOffsets[slot + 1];
+        } else if(mSeen[slot]) {
+            values.mBegin = &pair.mValue;
+            values.mEnd = values.mBegin + 1;
+        }
+        return values;
+    }
+
+    /**
+     * @brief Get every value of an argument given its name. See getAll
+     * @throw MissingArgument if there's no such argument
+     */
+    ArgValues getAll(const char* key) const {
+        if(mIndex == NULL) {
+            throw MissingArgument(key);
+        }
+        return this->getAll(key, *mIndex, mFinalArg);
+    }
+
+    /// @brief Get the positional arguments. Views of argv (zero-copy mode) or the result's copy of it
+    ArgValues getPositionals() const {
+        ArgValues values;
+        values.mBegin = mPositionals.data();
+        values.mEnd = values.mBegin + mPositionals.size();
+        return values;
+    }
+
+    /// @brief The name of the subcommand given. Empty if none was. See ArgParser::addSubcommand
+    StringView getSubcommand() const {
+        return mSubcommand;
+    }
+
+    /**
+     * @brief The subcommand's own arguments. Its global options are in this result
+     * @throw std::logic_error If no subcommand was given
+     */
+    const ArgParserResult& getSubcommandResult() const {
+        if(mSubcommand.empty()) {
+            throw std::logic_error("No subcommand was given");
+        }
+        return *mSubcommandResult;
+    }
+
+    void clear() {
+        mSubcommand = StringView();
+        mCompleted = false;
+        mEnvStorage.reset();
+        mSlots.clear();
+        mSeen.clear();
+        mValues.clear();
+        mValueOffsets.clear();
+        mOccurrences.clear();
+        mPositionals.clear();
+        mBoundValues.clear();
+        mStorage.clear();
+        mTokens.clear();
+        mResponseFiles.clear();
+        mExpandedTokens.clear();
+    }
+};
+/// Layout of a snapshot of a result. See ArgParser::snapshot and ArgSnapshot
+namespace detail {
+    /// Followed by the tables, in this order, then the blob of strings
+    struct SnapshotHeader {
+        char mMagic[8];             ///< "ARGSNAP"
+        uint32_t mByteOrder;        ///< SnapshotByteOrderMark in the writer's byte order
+        uint32_t mVersion;
+        uint64_t mFingerprint;      ///< The parser's ArgParser::getFingerprint
+        uint32_t mSlotCount;        ///< Entries in the slot table: one per argument, and the final argument
+        uint32_t mValueCount;       ///< Entries in the repeatable value table
+        uint32_t mPositionalCount;  ///< Entries in the positional table
+        uint32_t mBlobSize;
+    };
+
+    /// A string in the blob
+    struct SnapshotString {
+        uint32_t mOffset;
+        uint32_t mLength;
+    };
+
+    /// An entry in the slot table
+    struct SnapshotSlot {
+        SnapshotString mValue;
+        uint32_t mFlags;
+    };
+
+    static const uint32_t SnapshotByteOrderMark = 0x01020304;
+    static const uint32_t SnapshotVersion = 1;
+    /// Slot flags
+    static const uint32_t SnapshotHasPair = 1;  ///< The result had a pair for the slot. Otherwise it's out of range
+    static const uint32_t SnapshotSeen = 2;     ///< The argument was found
+
+    /// The table of the start and end of each slot's values in the repeatable value table has slots + 1 entries
+    inline size_t SnapshotSize(size_t pSlots, size_t pValues, size_t pPositionals, size_t pBlob) {
+        return sizeof(SnapshotHeader) + pSlots * sizeof(SnapshotSlot) + (pSlots + 1) * sizeof(uint32_t)
+            + (pValues + pPositionals) * sizeof(SnapshotString) + pBlob;
+    }
+}
+
+/**
+ * @brief The bytes of a snapshot, from ArgParser::snapshot. Held in 64-bit words, so they're aligned
+ * for ArgSnapshot::attach whichever memory resource they come from. An Arena packs chars unaligned
+ */
+class SnapshotBuffer {
+    static_assert(alignof(detail::SnapshotHeader) <= alignof(uint64_t), "Snapshot words must align the header");
+    Vector<uint64_t> mWords;
+    size_t mSize = 0;
+public:
+    explicit SnapshotBuffer(MemoryResource* pResource=DefaultResource()) : mWords(pResource) {}
+
+    /// @brief Make it pSize bytes, all zero
+    void resize(size_t pSize) {
+        this->mWords.assign((pSize + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+        this->mSize = pSize;
+    }
+
+    char* data() { return (char*)this->mWords.data(); }
+    const char* data() const { return (const char*)this->mWords.data(); }
+    size_t size() const { return this->mSize; }
+    bool empty() const { return this->mSize == 0; }
+};
+
+/// Storing values in the variables arguments are bound to. See ArgParser::bind
+namespace detail {
+    /**
+     * @brief Converts a number (see ArgPair::to) into the parse's record of it, then stores it once the
+     * parse succeeds. Each binder has the same two steps
+     */
+    template<typename T>
+    struct Binder {
+        static_assert(std::is_arithmetic<T>::value, "Arguments can be bound to numbers, bool, String, StringView or vectors of them");
+        static_assert(sizeof(T) <= sizeof(uint64_t), "A bound number must fit in 64 bits");
+
+        static ConvertError Convert(StringView pValue, uint64_t &pConverted) {
+            ArgPair pair;
+            pair.mValue = pValue;
+            T value = T();
+            ConvertError error = pair.to(value);
+            memcpy(&pConverted, &value, sizeof(T));
+            return error;
+        }
+
+        static void Store(void* pTarget, StringView, uint64_t pConverted, bool pFirst) {
+            // Like the results, the first occurrence wins. Later ones are still checked
+            if(pFirst) {
+                memcpy(pTarget, &pConverted, sizeof(T));
+            }
+        }
+    };
+
+    /// @brief Stores true, yes, on or 1 as true, and false, no, off or 0 as false
+    template<>
+    struct Binder<bool> {
+        static ConvertError Convert(StringView pValue, uint64_t &pConverted) {
+            if(pValue.empty()) {
+                return ConvertError::Empty;
+            } else if(pValue == "true" || pValue == "yes" || pValue == "on" || pValue == "1") {
+                pConverted = 1;
+            } else if(pValue == "false" || pValue == "no" || pValue == "off" || pValue == "0") {
+                pConverted = 0;
+            } else {
+                return ConvertError::Invalid;
+            }
+            return ConvertError::None;
+        }
+
+        static void Store(void* pTarget, StringView, uint64_t pConverted, bool pFirst) {
+            if(pFirst) {
+                *static_cast<bool*>(pTarget) = pConverted != 0;
+            }
+        }
+    };
+
+    template<>
+    struct Binder<String> {
+        static ConvertError Convert(StringView, uint64_t&) {
+            return ConvertError::None;
+        }
+
+        static void Store(void* pTarget, StringView pValue, uint64_t, bool pFirst) {
+            if(pFirst) {
+                static_cast<String*>(pTarget)->assign(pValue.data(), pValue.length());
+            }
+        }
+    };
+
+    /// @brief Stores a view of the value. Valid as long as the result of the parse is
+    template<>
+    struct Binder<StringView> {
+        static ConvertError Convert(StringView, uint64_t&) {
+            return ConvertError::None;
+        }
+
+        static void Store(void* pTarget, StringView pValue, uint64_t, bool pFirst) {
+            if(pFirst) {
+                *static_cast<StringView*>(pTarget) = pValue;
+            }
+        }
+    };
+
+    /// @brief Collects every occurrence. Cleared by the first one in each parse
+    template<typename T, typename A>
+    struct Binder<std::vector<T, A>> {
+        static ConvertError Convert(StringView pValue, uint64_t &pConverted) {
+            return Binder<T>::Convert(pValue, pConverted);
+        }
+
+        static void Store(void* pTarget, StringView pValue, uint64_t pConverted, bool pFirst) {
+            std::vector<T, A> &values = *static_cast<std::vector<T, A>*>(pTarget);
+            if(pFirst) {
+                values.clear();
+            }
+            T value = T();
+            Binder<T>::Store(&value, pValue, pConverted, true);
+            values.push_back(std::move(value));
+        }
+    };
+}
+
+/// @brief A variable that parsing stores an argument's value in. See ArgParser::bind
+struct ArgBinding {
+    void* mTarget = NULL;
+    /// Converts the value, into pConverted if it's a number or bool. Stores nothing, in case the parse fails
+    ConvertError (*mConvert)(StringView pValue, uint64_t &pConverted) = NULL;
+    /// Stores a value mConvert accepted in mTarget. pFirst is true for the first occurrence in a parse
+    void (*mStore)(void* pTarget, StringView pValue, uint64_t pConverted, bool pFirst) = NULL;
+};
+
+/**
+ * @brief The memory a parser's schema takes: its argument definitions, their strings and the indexes.
+ * Not the results, or the subcommands' parsers. See ArgParser::getSchemaFootprint
+ */
+struct SchemaFootprint {
+    size_t mArgs = 0;
+    /// The definitions added at runtime. Those in static tables (see ArgParser::addArgs) aren't the parser's
+    size_t mDefinitionBytes = 0;
+    /// The per-argument tables: definition pointers, traits, bindings, environment variables, completions
+    /// and constraints
+    size_t mTableBytes = 0;
+    /// The strings of the definitions added at runtime, and of the settings. Each distinct one is stored once
+    size_t mStringBytes = 0;
+    /// The blocks reserved for the strings. At least mStringBytes
+    size_t mStringReservedBytes = 0;
+    /// The name, config key, subcommand and string indexes
+    size_t mIndexBytes = 0;
+
+    /// @brief All the memory the schema takes
+    size_t total() const {
+        return this->mDefinitionBytes + this->mTableBytes + this->mStringReservedBytes + this->mIndexBytes;
+    }
+};
+
+class BulkParser;
+class ArgSnapshot;
+class LiveArgs;
+
+/**
+ * @brief C++ Argument Parser main class
+ * Prepare the parser arguments with addArg, addFlag, setFinalArg,
+ * and config parsing parameters with setProgramName, setCatchExceptions, setPrintHelpOnCaughtException.
+ * Not copyable or movable: results, subcommand parsers, snapshots and LiveArgs refer to it by address,
+ * so keep it where it's built (or behind a std::unique_ptr to hand it around)
+ */
+class ArgParser {
+private:
+    // Stage 1 - Initialization and setup
+    /// The name of the program
+    String mProgramName;
+    /// Config: Catch errors instead of throwing them up the call stack
+    bool mCfgCatchExceptions;
+    /// Config: On a caught error, print help info to the console
+    bool mCfgPrintHelpOnCaughtException;
+    /// Config: Point the results straight into the caller's argv instead of copying it
+    bool mCfgZeroCopy;
+    /// Config: Read more arguments from the response files named by '@path' arguments
+    bool mCfgResponseFiles = false;
+    /// Config: Answer the hidden '--__complete' argument with completions. See setCompletion
+    bool mCfgCompletion = false;
+    /// Config: Exit once parse(argc, argv) has answered with completions
+    bool mCfgCompletionExit = false;
+    /// Told about each parse, if compiled with CPP_ARG_PARSER_STATS. NULL if none
+    ParseObserver* mObserver = NULL;
+
+    /// The configured arguments
+    Vector<ArgDefPtr> mArgs;
+    /// The bits of an argument's definition a parse needs. See mArgTraits
+    enum Trait : uint8_t {
+        TraitFlag = 1,
+        TraitRepeatable = 2,
+        TraitOptional = 4,
+        TraitConstrained = 8    ///< Has a constraint in mConstraints
+    };
+    /// The Traits of each argument, indexed by slot, so a parse reads these bytes rather than the definitions.
+    /// One more than mArgs, for the final argument
+    Vector<uint8_t> mArgTraits;
+    /// Every argument's name then its aliases, split once as it's added. Lookups and completion scan
+    /// these rather than the definitions, which are left to help and errors
+    Vector<StringView> mNames;
+    /// Where each argument's names start in mNames, indexed by slot. One more than mArgs, so the names
+    /// of the argument in slot i are mNames[mNameStart[i]] up to mNames[mNameStart[i + 1]]
+    Vector<uint32_t> mNameStart;
+    /// The detail::EditDistance::CharBits of each of mNames, for suggest to filter them with. Built by finalize
+    Vector<uint64_t> mNameChars;
+    /// Storage for the definitions added at runtime, through addArg etc. Doesn't move them as it grows,
+    /// and its blocks double, so thousands of them cost a handful of allocations. See ownArgDef
+    Arena mOwnedArgs;
+    /// The number of definitions in mOwnedArgs
+    size_t mOwnedArgCount = 0;
+    /// Storage for the strings of the definitions added at runtime, and the settings. Interned
+    StringPool mStrings;
+    /// A name/alias->index into mArgs. Keys are views of the names in the definitions
+    ArgIndex mArgsIndex;
+    /// True if arguments were added since mArgsIndex was last built
+    bool mIndexDirty = false;
+    /// True if any of the arguments are repeatable
+    bool mHasRepeatable = false;
+    /// The final argument, if configured. NULL otherwise
+    ArgDefPtr mArgFinal = NULL;
+    /// True if the parser is configured with a final argument. Same as 'mArgFinal != null'
+    bool mHasFinalArg = false;
+    /// The positional arguments, if configured. NULL otherwise. Only its name and description are used
+    ArgDefPtr mPositionals = NULL;
+    /// The fewest and most positional arguments allowed
+    size_t mPositionalsMin = 0;
+    size_t mPositionalsMax = 0;
+    /// The character to split arguments by if possible. e.g. --config=./theConfig.cfg
+    StringView mArgSplitChar = "=";
+    /// The variables the arguments are bound to, indexed by slot. May be shorter than mArgs
+    Vector<ArgBinding> mBindings;
+    /// The variable the final argument is bound to
+    ArgBinding mFinalBinding;
+
+    // Other sources of values. The command line overrides the environment, which overrides config files
+    /// The environment variable each argument can be set by, indexed by slot. May be shorter than mArgs
+    Vector<StringView> mEnvVars;
+    /// The values from the environment, indexed by slot. Empty views are unset. See loadEnvironment
+    Vector<StringView> mEnvValues;
+    /// The copy of the environment values mEnvValues point into. Replaced by each load
+    std::shared_ptr<const Vector<char>> mEnvStorage;
+    /// The values from config files, grouped by slot: every one for a repeatable argument, otherwise the last.
+    /// Empty views are unset. See loadConfigFile
+    Vector<StringView> mConfigValues;
+    /// Where each slot's values start in mConfigValues, and (at [slot + 1]) end. Empty if none are loaded
+    Vector<uint32_t> mConfigOffsets;
+    /// The config files, which mConfigValues point into
+    Vector<MappedFile> mConfigFiles;
+    /// The names and aliases with their leading dashes removed, for config file keys. e.g. 'threads'
+    ArgIndex mBareIndex;
+    /// True if mBareIndex needs rebuilding, since arguments were added
+    bool mBareIndexDirty = true;
+    /// The values each argument completes to, comma-separated, indexed by slot. May be shorter than mArgs
+    Vector<StringView> mValueCompletions;
+    /// The constraints on each argument's value, indexed by slot. May be shorter than mArgs
+    Vector<detail::Constraint> mConstraints;
+
+    /// A subcommand, whose parser isn't built until it's needed. See addSubcommand
+    struct Subcommand {
+        StringView mName;
+        StringView mDescription;
+        std::function<void(ArgParser&)> mFactory;
+        /// Built once, by whichever thread needs it first
+        mutable std::once_flag mBuilt;
+        mutable std::unique_ptr<ArgParser> mParser;
+    };
+    /// The subcommands, in the order they were added
+    Vector<std::unique_ptr<Subcommand>> mSubcommands;
+    /// A name->index into mSubcommands
+    ArgIndex mSubcommandIndex;
+    /// If this is a subcommand's parser, the parser it belongs to. Options this one doesn't know are looked up there
+    const ArgParser* mParent = NULL;
+
+    /// The help text and example command, rendered for one width
+    struct HelpText {
+        size_t mWidth;
+        String mExampleCommand;
+        String mHelp;
+    };
+    /// Rendered on first use, and dropped when the arguments change. Guarded by HelpMutex. See getHelpText
+    mutable std::shared_ptr<const HelpText> mHelpText;
+    /// Config: The width to wrap the help at. 0 for the terminal's
+    size_t mHelpWidth = 0;
+
+    /**
+     * @brief Register the given argument definition in the parser.
+     * Adds it to the list. The index is rebuilt once, on the next finalize (or parse)
+     */
+    void registerArgDef(ArgDefPtr pArg) {
+        this->mArgs.push_back(pArg);
+        this->mArgTraits.back() = (pArg->mIsFlag ? TraitFlag : 0) | (pArg->mRepeatable ? TraitRepeatable : 0)
+            | (pArg->mOptional ? TraitOptional : 0);
+        this->mArgTraits.push_back(0);
+        this->mNames.push_back(pArg->mName);
+        for(StringView alias : CsvRange(pArg->mAliases)) {
+            this->mNames.push_back(alias);
+        }
+        this->mNameStart.push_back((uint32_t)this->mNames.size());
+        this->mIndexDirty = true;
+        this->mHelpText.reset();
+        this->mBareIndexDirty = true;
+        this->mHasRepeatable = this->mHasRepeatable || pArg->mRepeatable;
+        if(pArg->mEnvVar != NULL) {
+            this->mEnvVars.resize(this->mArgs.size());
+            this->mEnvVars.back() = pArg->mEnvVar;
+        }
+        if(pArg->isConstrained()) {
+            detail::Constraint &constraint = this->getConstraint((uint32_t)(this->mArgs.size() - 1));
+            if(pArg->mChoices != NULL) {
+                constraint.mChoicesText = pArg->mChoices;
+                constraint.mChoices.build(constraint.mChoicesText);
+            }
+            constraint.mPattern = pArg->mPattern != NULL ? StringView(pArg->mPattern) : StringView();
+            constraint.mHasRange = pArg->mHasRange;
+            constraint.mMin = pArg->mMin;
+            constraint.mMax = pArg->mMax;
+        }
+    };
+
+    /// @brief Keep a copy of a definition added at runtime, in mOwnedArgs
+    ArgDefPtr ownArgDef(const ArgDef &pDef) {
+        this->mOwnedArgCount++;
+        return new(this->mOwnedArgs.allocate(sizeof(ArgDef), alignof(ArgDef))) ArgDef(pDef);
+    }
+
+    /**
+     * @brief Keep a definition added by addArg etc, with copies of its strings. Its mNameBits are left 0:
+     * they're only for checking static tables with ArgDefsAreUnique, and hashing every name isn't free
+     */
+    ArgDefPtr ownArgDef(StringView pName, StringView pCSAliases, StringView pDesc, bool pOptional, bool pIsFlag, bool pRepeatable) {
+        // Names and aliases can't repeat, so only the description is interned
+        return this->ownArgDef(ArgDef{this->mStrings.store(pName), this->mStrings.store(pCSAliases), this->mStrings.intern(pDesc),
+            pOptional, pIsFlag, pRepeatable, 0, NULL, NULL, NULL, false, 0, 0});
+    }
+
+    /// @brief The constraints of the argument in the slot, for setting. Adds them if it has none
+    detail::Constraint& getConstraint(uint32_t slot) {
+        if(this->mConstraints.size() <= slot) {
+            this->mConstraints.resize(this->mArgs.size(), detail::Constraint(this->mArgs.get_allocator().mResource));
+        }
+        this->mArgTraits[slot] |= TraitConstrained;
+        this->mHelpText.reset();
+        return this->mConstraints[slot];
+    }
+
+    /// @brief The slot of an argument, for configuring it. Finalizes first if needed
+    uint32_t getSlotToConfigure(StringView pName, const char* pWhat) {
+        if(this->mIndexDirty) {
+            this->finalize();
+        }
+        uint32_t slot = this->getArgSlot(pName);
+        if(slot == ArgIndex::npos) {
+            throw std::invalid_argument(String("Can't set the ") + pWhat + " of unknown argument: " + pName.toString());
+        }
+        return slot;
+    }
+
+    /**
+     * @brief Get the slot of an argument definition given its name or alias.
+     * The slot is its index in mArgs. ArgIndex::npos if it doesn't exist
+     */
+    uint32_t getArgSlot(StringView key) const {
+        return this->mArgsIndex.find(key);
+    }
+
+    /// @brief The slot of the final argument. After all the others
+    uint32_t getFinalArgSlot() const {
+        return (uint32_t)this->mArgs.size();
+    }
+
+    /// @brief The variable the argument in the slot is bound to. Its mStore is NULL if it isn't bound
+    const ArgBinding& getBinding(uint32_t slot) const {
+        static const ArgBinding unbound;
+        if(slot == this->getFinalArgSlot()) {
+            return this->mFinalBinding;
+        }
+        return slot < this->mBindings.size() ? this->mBindings[slot] : unbound;
+    }
+
+    template<typename T>
+    void bindSlot(uint32_t slot, T* pTarget) {
+        ArgBinding &binding = slot == this->getFinalArgSlot() ? this->mFinalBinding : this->mBindings[slot];
+        binding.mTarget = pTarget;
+        binding.mConvert = &detail::Binder<T>::Convert;
+        binding.mStore = &detail::Binder<T>::Store;
+    }
+
+    // Stage 2 - Results after parsing
+
+    /// A struct for storing results in. Makes life a bit cleaner
+    ArgParserResult mResult;
+
+    friend class BulkParser;
+    friend class ArgSnapshot;
+    friend class LiveArgs;
+
+    /**
+     * @brief Adds the found argument (and its value) to the result struct.
+     * A flag's value must already be normalised. See NormaliseFlag
+     */
+    void handleArgPair(ArgParserResult &result, uint32_t slot, ArgDefPtr def, StringView value) const {
+        if(this->mArgTraits[slot] & TraitRepeatable) {
+            result.addOccurrence(slot, value);
+        }
+        result.setResult(slot, def, value);
+    }
+
+public:
+    ArgParser() : ArgParser(DefaultResource()) {}
+
+    /**
+     * @brief Create a parser that gets all of its memory from the given resource.
+     * Definitions, the index and the results (including the copy of argv) are all allocated
+     * from it. With an Arena, they're then all freed in one go by Arena::release,
+     * once the parser is gone.
+     * @param pResource Must outlive the parser
+     */
+    explicit ArgParser(MemoryResource* pResource)
+        : mArgs(pResource), mArgTraits(1, 0, pResource), mNames(pResource), mNameStart(1, 0, pResource), mNameChars(pResource), mOwnedArgs(16 * sizeof(ArgDef), pResource), mStrings(pResource), mArgsIndex(pResource), mBindings(pResource),
+          mEnvVars(pResource), mEnvValues(pResource), mConfigValues(pResource), mConfigOffsets(pResource), mConfigFiles(pResource),
+          mBareIndex(pResource), mValueCompletions(pResource), mConstraints(pResource), mSubcommands(pResource), mSubcommandIndex(pResource), mResult(pResource) {
+        this->mProgramName = "PROGRAM";
+        this->mCfgCatchExceptions = false;
+        this->mCfgPrintHelpOnCaughtException = true;
+        this->mCfgZeroCopy = false;
+    };
+    ArgParser(const ArgParser&) = delete;
+    ArgParser& operator=(const ArgParser&) = delete;
+
+    /**
+     * @brief Build the name/alias lookup index for the configured arguments.
+     * Done automatically by 'parse' if arguments were added since, but can be called
+     * up front to keep the cost out of the first parse.
+     * If a name is used more than once, the first argument to use it wins.
+     */
+    void finalize() {
+        this->mArgsIndex.reset(this->mNames.size());
+        this->mNameChars.resize(this->mNames.size());
+        for(uint32_t slot = 0; slot < this->mArgs.size(); slot++) {
+            for(uint32_t i = this->mNameStart[slot]; i < this->mNameStart[slot + 1]; i++) {
+                this->mArgsIndex.insert(this->mNames[i], slot);
+                this->mNameChars[i] = detail::EditDistance::CharBits(this->mNames[i]);
+            }
+        }
+        this->mSubcommandIndex.reset(this->mSubcommands.size());
+        for(size_t i = 0; i < this->mSubcommands.size(); i++) {
+            this->mSubcommandIndex.insert(this->mSubcommands[i]->mName, (uint32_t)i);
+        }
+        if(this->mHasFinalArg && !this->mSubcommands.empty()) {
+            throw std::logic_error("A parser with subcommands can't have a final argument");
+        }
+        this->mIndexDirty = false;
+    }
+
+    /**
+     * @brief Creates a help string for the configured arg parser, wrapped to the width (see setHelpWidth).
+     * Rendered once, until the arguments change
+     */
+    String getHelp() const {
+        return this->getHelpText()->mHelp;
+    }
+
+    /**
+     * @brief Creates an example command for the configured arg parser. On one line
+     */
+    String getExampleCommand() const {
+        return this->getHelpText()->mExampleCommand;
+    }
+
+    /**
+     * @brief Print the help, in a single write rather than through stdio. Flushes stdout first,
+     * to keep the order of anything printed before it
+     * @param pFd The file descriptor to write to. e.g. 2 for stderr
+     */
+    void printHelp(int pFd=1) const {
+        std::shared_ptr<const HelpText> text = this->getHelpText();
+        fflush(stdout);
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        const char* data = text->mHelp.data();
+        size_t remaining = text->mHelp.size();
+        while(remaining > 0) {
+            ssize_t written = write(pFd, data, remaining);
+            if(written < 0 && errno == EINTR) {
+                continue;
+            } else if(written <= 0) {
+                return;
+            }
+            data += written;
+            remaining -= (size_t)written;
+        }
+#else
+        FILE* file = pFd == 2 ? stderr : stdout;
+        fwrite(text->mHelp.data(), 1, text->mHelp.size(), file);
+        fflush(file);
+#endif
+    }
+
+    /**
+     * @brief Get the argument pair given the argument name.
+     * @throw MissingArgument if the pair doesn't exist
+     */
+    const ArgPair& operator[](const char* key) {
+        if(this->mIndexDirty) {
+            this->finalize();
+        }
+        return this->mResult.get(key, this->mArgsIndex, this->mArgFinal);
+    };
+
+    /**
+     * @brief Get every value of an argument given its name. See ArgParserResult::getAll
+     * @throw MissingArgument if there's no such argument
+     */
+    ArgValues getAll(const char* key) {
+        if(this->mIndexDirty) {
+            this->finalize();
+        }
+        return this->mResult.getAll(key, this->mArgsIndex, this->mArgFinal);
+    }
+
+    /// @brief Get the positional arguments. See setPositionals
+    ArgValues getPositionals() const {
+        return this->mResult.getPositionals();
+    }
+
+    /// @brief The name of the subcommand given. Empty if none was. See addSubcommand
+    StringView getSubcommand() const {
+        return this->mResult.getSubcommand();
+    }
+
+    /// @brief True if the last parse printed completions instead of parsing. See setCompletion
+    bool isCompleted() const {
+        return this->mResult.mCompleted;
+    }
+
+    /**
+     * @brief The subcommand's own arguments. Its global options are read through this parser
+     * @throw std::logic_error If no subcommand was given
+     */
+    const ArgParserResult& getSubcommandResult() const {
+        return this->mResult.getSubcommandResult();
+    }
+
+    // Parsing functions
+
+    /**
+     * @brief Parse the command line arguments, validating them too
+     * Finds all arguments and flags. If a non-optional argument is missing,
+     * will throw a MissingArgument exception. If an optional argument is missing,
+     * will populate the result with an empty string for the argument.
+     * If there is an argument without a value, will throw 'MissingValue' exception.
+     * 
+     * If configured, will catch the exceptions instead, and only return true/false
+     * If configured, will print help / error messages to stdout and stderr.
+     *
+     * By default argv is copied once into the result. In zero-copy mode (see setZeroCopy)
+     * the results point straight into argv, which must then outlive them.
+     *
+     * Values of arguments bound to variables (see bind) are stored in them as they're found.
+     * If one can't be converted, throws InvalidValue.
+     */
+    bool parse(int argc, char const* const* argv) {
+        // Not for completions, which scan the names: a TAB press shouldn't pay for building the index
+        if(this->mIndexDirty && !this->isCompletionRequest(argc, argv)) {
+            this->finalize();
+        }
+        bool isParsed = this->parse(argc, argv, this->mResult);
+        if(this->mResult.mCompleted && this->mCfgCompletionExit) {
+            exit(0);
+        }
+        return isParsed;
+    }
+
+    /**
+     * @brief Parse the command line arguments into the given result, rather than the parser's own.
+     * Otherwise the same as parse(argc, argv). Read the values with the result's operator[].
+     *
+     * Doesn't modify the parser, so once finalize has been called any number of threads
+     * can parse against one parser at the same time, each into their own result.
+     * Unless arguments are bound to variables (see bind): they're written by every parse.
+     * The parser must outlive the results.
+     * @return False if it failed, or answered a completion request instead (see pResult.mCompleted)
+     * @throw std::logic_error If arguments were added since finalize was last called. Completions don't need it
+     */
+    bool parse(int argc, char const* const* argv, ArgParserResult &pResult) const {
+        ParseError error = this->tryParse(argc, argv, pResult);
+        if(!error) {
+            return true; // Success
+        }
+        if(error.mKind == ErrorKind::Completed) {
+            return false;
+        }
+        if(!this->mCfgCatchExceptions) {
+            error.raise();
+        }
+        if(this->mCfgPrintHelpOnCaughtException) {
+            const char* key = error.mKey.data();
+            int keyLength = (int)error.mKey.length();
+            switch(error.mKind) {
+                case ErrorKind::UnknownArgument:
+                    fprintf(stderr, "Error: Unknown argument provided: %.*s%s\n", keyLength, key,
+                        detail::DidYouMean(error.mSuggestions, error.mSuggestions + error.mSuggestionCount).c_str());
+                    break;
+                case ErrorKind::MissingArgument:
+                    fprintf(stderr, "Error: Required argument %.*s is missing\n", keyLength, key);
+                    break;
+                case ErrorKind::MissingValue:
+                    fprintf(stderr, "Error: Last argument %.*s is missing corresponding value\n", keyLength, key);
+                    if(this->mHasFinalArg) {
+                        fprintf(stderr, "  Hint: Did you forget the final argument '%s'?\n", this->mArgFinal->mName);
+                    }
+                    break;
+                case ErrorKind::InvalidValue:
+                    fprintf(stderr, "Error: Invalid value %.*s for argument %.*s\n",
+                        (int)error.mValue.length(), error.mValue.data(), keyLength, key);
+                    break;
+                case ErrorKind::UnterminatedQuote:
+                case ErrorKind::ResponseFile:
+                case ErrorKind::ResponseFileCycle:
+                    fprintf(stderr, "Error: %s\n", error.message().c_str());
+                    break;
+                default:
+                    break;
+            }
+            // The suggestions are more use than the help, which may list thousands of arguments
+            if(error.mKind != ErrorKind::UnknownArgument || error.mSuggestionCount == 0) {
+                this->printHelp();
+            }
+        }
+
+        return false; // Something went wrong
+    }
+
+    /**
+     * @brief Parse into the given result, reporting any error as a value instead of throwing.
+     * Ignores setCatchExceptions and setPrintHelpOnCaughtException: no error is printed,
+     * and no message is built unless ParseError::message is called.
+     * The one exception is a completion request, when completion is on (see setCompletion):
+     * answering it means printing the completions to stdout.
+     * Otherwise the same as parse(argc, argv, pResult). e.g.
+     *   if(argparse::ParseError error = argParser.tryParse(argc, argv, result)) { ... }
+     * @return The error, which refers into pResult and the parser. Converts to false if there wasn't one.
+     *   Completed if argv asked for completions, which were printed instead: the program should then exit
+     * @throw std::logic_error If arguments were added since finalize was last called. Completions don't need it
+     */
+    ParseError tryParse(int argc, char const* const* argv, ArgParserResult &pResult) const {
+        ParseError error;
+        if(this->printCompletions(argc, argv)) {
+            pResult.clear();
+            pResult.mCompleted = true;
+            error.mKind = ErrorKind::Completed;
+            return error;
+        }
+        if(this->mIndexDirty) {
+            throw std::logic_error("ArgParser::finalize must be called after adding arguments, before parsing");
+        }
+        ARG_STATS(
+            ParseStats &stats = pResult.mStats;
+            stats = ParseStats();
+            detail::StatsClock::time_point start = detail::StatsClock::now();
+            size_t allocations = detail::ThreadAllocations();
+            size_t allocatedBytes = detail::ThreadAllocatedBytes();
+        )
+        pResult.clear();
+        pResult.setArgv(argc, argv, this->mCfgZeroCopy);
+        bool isTokenized = !this->mCfgResponseFiles || this->expandResponseFiles(pResult, error);
+        ARG_STATS(stats.mTokenizeNs = detail::ElapsedNs(start);)
+        if(isTokenized && this->parseTokens(pResult, error, true)) {
+            ARG_STATS(detail::PhaseTimer timer(stats.mConvertNs);)
+            this->commitBindings(pResult);
+        }
+        ARG_STATS(
+            stats.mTotalNs = detail::ElapsedNs(start);
+            stats.mAllocations = detail::ThreadAllocations() - allocations;
+            stats.mAllocatedBytes = detail::ThreadAllocatedBytes() - allocatedBytes;
+            if(this->mObserver != NULL) {
+                this->mObserver->onParse(stats, error);
+            }
+        )
+        return error;
+    }
+
+private:
+    /// @brief True if the token names a response file. e.g. '@args.txt'
+    static bool IsResponseFile(StringView pToken) {
+        return pToken.length() > 1 && pToken[0] == '@';
+    }
+
+    /**
+     * @brief Replace each '@path' token in pResult.mTokens with the tokens in the file.
+     * The files are mapped copy-on-write and kept in the result. Tokens are views of them,
+     * unquoted in place, so only pages with quoted tokens are ever copied.
+     * @param pError Set if it fails. The token index is that of the '@path' in argv
+     * @return False if it fails
+     */
+    bool expandResponseFiles(ArgParserResult &pResult, ParseError &pError) const {
+        Vector<StringView> &tokens = pResult.mTokens;
+        size_t i = 1;
+        while(i < tokens.size() && !IsResponseFile(tokens[i])) {
+            i++;
+        }
+        if(i == tokens.size()) {
+            return true; // None. The usual case, so it costs no more than this check
+        }
+        Vector<StringView> &expanded = pResult.mExpandedTokens;
+        expanded.assign(tokens.begin(), tokens.begin() + i);
+        Vector<size_t> including(pResult.mResponseFiles.get_allocator());
+        for(; i < tokens.size(); i++) {
+            if(!IsResponseFile(tokens[i])) {
+                expanded.push_back(tokens[i]);
+            } else if(!this->expandResponseFile(pResult, tokens[i].substr(1), including, pError)) {
+                pError.mTokenIndex = i;
+                return false;
+            }
+        }
+        tokens.swap(expanded);
+        return true;
+    }
+
+    /**
+     * @brief Append the tokens in the response file to pResult.mExpandedTokens, expanding any it includes
+     * @param pIncluding The files (indexes into pResult.mResponseFiles) that include this one
+     */
+    bool expandResponseFile(ArgParserResult &pResult, StringView pPath, Vector<size_t> &pIncluding, ParseError &pError) const {
+        pError.mKey = pPath;
+        pError.mPosition = 0;
+        MappedFile file;
+        if(!file.open(pPath.toString().c_str(), true)) {
+            pError.mKind = ErrorKind::ResponseFile;
+            return false;
+        }
+        for(size_t including : pIncluding) {
+            if(pResult.mResponseFiles[including].isSameFile(file)) {
+                pError.mKind = ErrorKind::ResponseFileCycle;
+                return false;
+            }
+        }
+        pResult.mResponseFiles.push_back(std::move(file));
+        size_t fileIndex = pResult.mResponseFiles.size() - 1;
+        MappedFile &mapped = pResult.mResponseFiles.back();
+
+        ShellTokenizer tokenizer(mapped.data(), mapped.view().length());
+        StringView token;
+        char* inPlace = NULL;
+        ShellTokenizer::Status status;
+        while((status = tokenizer.next(token, inPlace)) == ShellTokenizer::Token) {
+            if(!IsResponseFile(token)) {
+                pResult.mExpandedTokens.push_back(token);
+                continue;
+            }
+            pIncluding.push_back(fileIndex);
+            bool expanded = this->expandResponseFile(pResult, token.substr(1), pIncluding, pError);
+            pIncluding.pop_back();
+            if(!expanded) {
+                return false;
+            }
+        }
+        if(status == ShellTokenizer::UnterminatedQuote) {
+            pError.mKind = ErrorKind::UnterminatedQuote;
+            pError.mKey = pPath;
+            pError.mPosition = tokenizer.position();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Parse the tokens already in pResult.mTokens into the rest of the result
+     * The first token is skipped, being the executable.
+     * @param pError Set if it fails
+     * @param pBind Check the values convert for the variables the arguments are bound to, and record them
+     *   in pResult.mBoundValues for commitBindings
+     * @param pFlagValues Set a flag given a value to it, e.g. '--colour=false'. Otherwise it's set
+     *   by being given, whatever the value. See LiveArgs
+     * @return False if it fails
+     */
+    bool parseTokens(ArgParserResult &pResult, ParseError &pError, bool pBind, bool pFlagValues=false) const {
+        pResult.mIndex = &this->mArgsIndex;
+        pResult.mFinalArg = this->mArgFinal;
+        pResult.resetSlots(this->mArgs.size() + 1, this->mHasRepeatable);
+        ARG_STATS(pResult.mStats.mTokens += pResult.mTokens.size();)
+        {
+            ARG_STATS(detail::PhaseTimer timer(pResult.mStats.mLookupNs);)
+            if(!this->matchTokens(pResult, pError, pBind, pFlagValues)) {
+                return false;
+            }
+        }
+        ARG_STATS(detail::PhaseTimer timer(pResult.mStats.mValidateNs);)
+        return this->completeResult(pResult, pError, pBind);
+    }
+
+    /**
+     * @brief Match the tokens to the arguments, recording their values in the result
+     * @param pFlagValues See parseTokens
+     * @return False if it fails, with pError set
+     */
+    bool matchTokens(ArgParserResult &pResult, ParseError &pError, bool pBind, bool pFlagValues) const {
+        const Vector<StringView> &tokens = pResult.mTokens;
+        size_t firstArgIndex = 1; // Skip the first arg, usually the executable
+        size_t lastArgIndex = tokens.size();
+        if(this->mHasFinalArg && lastArgIndex > 0) {
+            lastArgIndex--;
+        }
+
+        StringView key, val;
+        size_t keyIndex = 0, valIndex = 0, valPosition = 0;
+        uint32_t slot = 0;
+        ArgDefPtr def = NULL;
+        bool isFlag = false;
+        // The parser the argument belongs to, and its result. A parent's for a subcommand's global options
+        const ArgParser* owner = this;
+        ArgParserResult* ownerResult = &pResult;
+        bool isKey = true, isDone = false, isPositionalOnly = false;
+        // For every valid argument, find the key-value pair. Or just 'key' if it's a flag.
+        for(size_t i = firstArgIndex; i < lastArgIndex; i++) {
+            StringView component = tokens[i];
+            
+            LOG("Handling %.*s\n", (int)component.length(), component.data());
+
+            if(isKey) {
+                keyIndex = i;
+                // The rest belongs to the subcommand
+                if(!this->mSubcommands.empty() && !isPositionalOnly && !IsOptionLike(component)) {
+                    uint32_t subcommand = this->mSubcommandIndex.find(component);
+                    if(subcommand != ArgIndex::npos) {
+                        if(!this->parseSubcommand(pResult, *this->mSubcommands[subcommand], i, pError, pBind)) {
+                            return false;
+                        }
+                        break;
+                    }
+                }
+                if(this->mPositionals != NULL) {
+                    // Everything after a '--' is positional
+                    if(!isPositionalOnly && component == "--") {
+                        isPositionalOnly = true;
+                        continue;
+                    }
+                    ARG_STATS(
+                        if(!isPositionalOnly && !IsOptionLike(component)) {
+                            pResult.mStats.mLookups++;
+                            pResult.mStats.mLookupMisses += this->getArgSlot(component) == ArgIndex::npos;
+                        }
+                    )
+                    if(isPositionalOnly || (!IsOptionLike(component) && this->getArgSlot(component) == ArgIndex::npos)) {
+                        if(pResult.mPositionals.size() >= this->mPositionalsMax) {
+                            pError.mKind = ErrorKind::UnknownArgument;
+                            pError.mKey = component;
+                            pError.mTokenIndex = i;
+                            pError.mPosition = 0;
+                            return false;
+                        }
+                        pResult.mPositionals.push_back(component);
+                        continue;
+                    }
+                }
+                bool isSplit = SplitArg(component, key, val);
+                if(!isSplit) {
+                    key = component;
+                }
+                slot = this->getArgSlot(key);
+                owner = this;
+                ownerResult = &pResult;
+                while(slot == ArgIndex::npos && owner->mParent != NULL) {
+                    owner = owner->mParent;
+                    ownerResult = ownerResult->mParentResult;
+                    slot = owner->getArgSlot(key);
+                }
+                ARG_STATS(pResult.mStats.mLookups++; pResult.mStats.mLookupMisses += slot == ArgIndex::npos;)
+                if(slot == ArgIndex::npos) {
+                    pError.mKind = ErrorKind::UnknownArgument;
+                    pError.mKey = key;
+                    pError.mTokenIndex = i;
+                    pError.mPosition = 0;
+                    this->suggest(key, pError);
+                    return false;
+                }
+                def = owner->mArgs[slot];
+                isFlag = (owner->mArgTraits[slot] & TraitFlag) != 0;
+                valIndex = i;
+                valPosition = isSplit ? key.length() + this->mArgSplitChar.length() : 0;
+                if(isFlag) {
+                    // A flag's existence sets it, unless it's asked to take a value given. e.g. --colour=false
+                    if(!isSplit || !pFlagValues) {
+                        val = "true";
+                    } else if(!NormaliseFlag(val)) {
+                        pError.mKind = ErrorKind::InvalidValue;
+                        pError.mKey = key;
+                        pError.mValue = val;
+                        pError.mConvertError = ConvertError::Invalid;
+                        pError.mTokenIndex = i;
+                        pError.mPosition = valPosition;
+                        return false;
+                    }
+                    isDone = true;
+                } else if(isSplit) {
+                    isDone = true;
+                } else {
+                    isKey = false;
+                }
+            } else {
+                val = component;
+                valIndex = i;
+                isDone = true;
+                isKey = true;
+            }
+
+            if(isDone) {
+                isDone = false;
+                LOG("Got: (%.*s) -> (%.*s)\n", (int)key.length(), key.data(), (int)val.length(), val.data());
+                if(!owner->acceptValue(*ownerResult, slot, key, val, pError, pBind)) {
+                    pError.mTokenIndex = valIndex;
+                    pError.mPosition = valPosition;
+                    return false;
+                }
+                owner->handleArgPair(*ownerResult, slot, def, val);
+                key = StringView();
+                val = StringView();
+                def = NULL;
+            }
+        }
+        // We found a key but not value for it. Must be missing something
+        if(!isKey) {
+            pError.mKind = ErrorKind::MissingValue;
+            pError.mKey = key;
+            pError.mTokenIndex = keyIndex;
+            pError.mPosition = key.length();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Match a partial set of arguments, without checking for missing ones or filling anything in.
+     * Flags are set to the values given. See LiveArgs::apply
+     * @return False if it fails, with pError set
+     */
+    bool matchPartial(ArgParserResult &pResult, ParseError &pError) const {
+        pResult.mIndex = &this->mArgsIndex;
+        pResult.mFinalArg = this->mArgFinal;
+        pResult.resetSlots(this->mArgs.size() + 1, this->mHasRepeatable);
+        if(!this->matchTokens(pResult, pError, false, true)) {
+            return false;
+        }
+        pResult.groupValues();
+        return true;
+    }
+
+    /**
+     * @brief Fill in the error's suggestions: the names, aliases and subcommands closest to the unknown key,
+     * here and in the parents. Within a third of its length in edits. Allocates nothing
+     */
+    void suggest(StringView pKey, ParseError &pError) const {
+        pError.mSuggestionCount = 0;
+        size_t bound = pKey.length() / 3;
+        if(bound == 0 || pKey.length() > detail::EditDistance::MaxLength) {
+            return;
+        }
+        detail::EditDistance editDistance(pKey);
+        size_t distances[ParseError::MaxSuggestions];
+        // Keep the closest, in order. Ties go to the first found
+        auto consider = [&](StringView pCandidate, uint64_t pChars) {
+            size_t &count = pError.mSuggestionCount;
+            // Once there are enough, only closer ones matter
+            size_t limit = count == ParseError::MaxSuggestions ? distances[count - 1] - 1 : bound;
+            if(editDistance.isOver(pCandidate, pChars, limit)) {
+                return;
+            }
+            size_t distance = editDistance.distance(pCandidate, limit);
+            if(distance > limit) {
+                return;
+            }
+            for(size_t i = 0; i < count; i++) {
+                if(pError.mSuggestions[i] == pCandidate) {
+                    return;
+                }
+            }
+            size_t i = count < ParseError::MaxSuggestions ? count++ : count - 1;
+            for(; i > 0 && distances[i - 1] > distance; i--) {
+                distances[i] = distances[i - 1];
+                pError.mSuggestions[i] = pError.mSuggestions[i - 1];
+            }
+            distances[i] = distance;
+            pError.mSuggestions[i] = pCandidate;
+        };
+        for(const ArgParser* parser = this; parser != NULL; parser = parser->mParent) {
+            for(size_t i = 0; i < parser->mNames.size(); i++) {
+                consider(parser->mNames[i], parser->mNameChars[i]);
+            }
+        }
+        for(const std::unique_ptr<Subcommand> &subcommand : this->mSubcommands) {
+            consider(subcommand->mName, detail::EditDistance::CharBits(subcommand->mName));
+        }
+    }
+
+    /// @brief Guards every parser's mHelpText, so help can be asked for from any thread. It rarely is
+    static std::mutex& HelpMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    /// @brief The rendered help, rendering it if the arguments or width have changed since it last was
+    std::shared_ptr<const HelpText> getHelpText() const {
+        size_t width = this->getHelpWidth();
+        std::lock_guard<std::mutex> lock(HelpMutex());
+        if(!this->mHelpText || this->mHelpText->mWidth != width) {
+            this->mHelpText = this->renderHelp(width);
+        }
+        return this->mHelpText;
+    }
+
+    /// @brief The width to wrap the help at. See setHelpWidth
+    size_t getHelpWidth() const {
+        if(this->mHelpWidth != 0) {
+            return this->mHelpWidth;
+        }
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        struct winsize size;
+        if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) {
+            return size.ws_col;
+        }
+#endif
+        const char* columns = getenv("COLUMNS");
+        long width = columns != NULL ? strtol(columns, NULL, 10) : 0;
+        return width > 0 ? (size_t)width : 80;
+    }
+
+    /**
+     * @brief Append the words of pText, wrapping before any that would pass pWidth.
+     * Wrapped lines start with pIndent spaces. pColumn is the column the text starts at, and is left
+     * at the one it ends at. The first word on a line is never wrapped, however long
+     */
+    static void AppendWrapped(String &pOut, StringView pText, size_t pWidth, size_t pIndent, size_t &pColumn) {
+        const char* pos = pText.begin();
+        while(pos != pText.end()) {
+            const char* wordEnd = std::find(pos, pText.end(), ' ');
+            size_t length = (size_t)(wordEnd - pos);
+            if(length > 0) {
+                if(pColumn > pIndent && pColumn + 1 + length > pWidth) {
+                    pOut += '\n';
+                    pOut.append(pIndent, ' ');
+                    pColumn = pIndent;
+                } else if(pColumn > pIndent) {
+                    pOut += ' ';
+                    pColumn++;
+                }
+                pOut.append(pos, length);
+                pColumn += length;
+            }
+            pos = wordEnd == pText.end() ? wordEnd : wordEnd + 1;
+        }
+    }
+
+    /// @brief Render the help and example command. Built up in single strings, rather than through streams
+    std::shared_ptr<const HelpText> renderHelp(size_t pWidth) const {
+        std::shared_ptr<HelpText> text = std::make_shared<HelpText>();
+        text->mWidth = pWidth;
+        String &command = text->mExampleCommand;
+        command = this->mProgramName + " ";
+        for(ArgDefPtr def : this->mArgs) {
+            if(def->mIsFlag) {
+                command.append("[").append(def->mName).append("] ");
+            } else if(def->mOptional) {
+                command.append("[").append(def->mName).append(" <value>]").append(def->mRepeatable ? "... " : " ");
+            } else {
+                command.append("<").append(def->mName).append(" <value>>").append(def->mRepeatable ? "... " : " ");
+            }
+        }
+        if(this->mPositionals != NULL) {
+            if(this->mPositionalsMin == 0) {
+                command.append("[").append(this->mPositionals->mName).append("...] ");
+            } else {
+                command.append("<").append(this->mPositionals->mName).append(">... ");
+            }
+        }
+        if(this->mHasFinalArg) {
+            command.append(this->mArgFinal->mName);
+        }
+        if(!this->mSubcommands.empty()) {
+            command.append("<command> [<args>]");
+        }
+
+        String &help = text->mHelp;
+        help.reserve(command.size() * 2 + 64);
+        help.append("Example Command: \n  ");
+        size_t column = 2;
+        AppendWrapped(help, command, pWidth, 4, column);
+        help.append("\n\n");
+        // Reused for each description
+        String description;
+        for(uint32_t slot = 0; slot < this->mArgs.size(); slot++) {
+            ArgDefPtr def = this->mArgs[slot];
+            help.append("  ").append(def->mName);
+            for(StringView alias : CsvRange(def->mAliases)) {
+                help.append(", ").append(alias.data(), alias.length());
+            }
+            if(!def->mIsFlag) {
+                help.append(def->mRepeatable ? " <value>..." : " <value>");
+            }
+            description.assign(def->mDescription);
+            if(!def->mIsFlag) {
+                description.append(def->mOptional ? ": Optional" : ": Mandatory");
+            }
+            if(slot < this->mConstraints.size()) {
+                const detail::Constraint &constraint = this->mConstraints[slot];
+                if(!constraint.mChoicesText.empty()) {
+                    description.append(". One of: ");
+                    for(StringView choice : CsvRange(constraint.mChoicesText)) {
+                        description.append(choice.data(), choice.length()).append(" ");
+                    }
+                    description.pop_back();
+                }
+                if(constraint.mHasRange) {
+                    std::ostringstream range;
+                    range << ". From " << constraint.mMin << " to " << constraint.mMax;
+                    description.append(range.str());
+                }
+                if(!constraint.mPattern.empty()) {
+                    description.append(". Matching: ").append(constraint.mPattern.data(), constraint.mPattern.length());
+                }
+            }
+            help.append("\n    ");
+            column = 4;
+            AppendWrapped(help, description, pWidth, 4, column);
+            help.append("\n\n");
+        }
+        if(this->mPositionals != NULL) {
+            help.append("  ").append(this->mPositionals->mName).append("...\n    ");
+            column = 4;
+            AppendWrapped(help, this->mPositionals->mDescription, pWidth, 4, column);
+            help.append("\n\n");
+        }
+        if(this->mHasFinalArg) {
+            help.append("  ").append(this->mArgFinal->mName).append("\n    ");
+            column = 4;
+            AppendWrapped(help, this->mArgFinal->mDescription, pWidth, 4, column);
+            help.append("\n\n");
+        }
+        if(!this->mSubcommands.empty()) {
+            // Listed without building them
+            help.append("Commands:\n");
+            for(const std::unique_ptr<Subcommand> &subcommand : this->mSubcommands) {
+                help.append("  ").append(subcommand->mName.data(), subcommand->mName.length()).append("\n    ");
+                column = 4;
+                AppendWrapped(help, subcommand->mDescription, pWidth, 4, column);
+                help.append("\n\n");
+            }
+        }
+        return text;
+    }
+
+    /// @brief The subcommand's parser, building it if this is the first time it's needed
+    const ArgParser& buildSubcommand(const Subcommand &pSubcommand) const {
+        std::call_once(pSubcommand.mBuilt, [this, &pSubcommand]() {
+            std::unique_ptr<ArgParser> parser(new ArgParser(this->mArgs.get_allocator().mResource));
+            parser->mParent = this;
+            parser->mProgramName = this->mProgramName + " " + pSubcommand.mName.toString();
+            pSubcommand.mFactory(*parser);
+            parser->finalize();
+            pSubcommand.mParser = std::move(parser);
+        });
+        return *pSubcommand.mParser;
+    }
+
+    // Completion looks names up by scanning, not with the indexes: each completion is a new
+    // process, which would spend longer building an index than a scan takes
+
+    /// @brief Find an argument by name or alias, here or in a parent. NULL if there's no such argument
+    ArgDefPtr findArgForCompletion(StringView key, const ArgParser* &pOwner, uint32_t &pSlot) const {
+        for(pOwner = this; pOwner != NULL; pOwner = pOwner->mParent) {
+            const Vector<StringView> &names = pOwner->mNames;
+            for(uint32_t i = 0; i < names.size(); i++) {
+                if(key == names[i]) {
+                    // The last slot whose names start at or before it
+                    const Vector<uint32_t> &starts = pOwner->mNameStart;
+                    pSlot = (uint32_t)(std::upper_bound(starts.begin(), starts.end(), i) - starts.begin()) - 1;
+                    return pOwner->mArgs[pSlot];
+                }
+            }
+        }
+        return NULL;
+    }
+
+    /// @brief Add the names and aliases starting with pPrefix, here and in the parents
+    void completeName(StringView pPrefix, Vector<StringView> &pOut) const {
+        for(const ArgParser* parser = this; parser != NULL; parser = parser->mParent) {
+            for(StringView name : parser->mNames) {
+                if(name.startsWith(pPrefix)) {
+                    pOut.push_back(name);
+                }
+            }
+        }
+    }
+
+    /// @brief Add the values of the argument in the slot starting with pPrefix. See setCompletions
+    void completeValue(uint32_t pSlot, StringView pPrefix, Vector<StringView> &pOut) const {
+        StringView values = pSlot < this->mValueCompletions.size() ? this->mValueCompletions[pSlot] : StringView();
+        // Otherwise its choices
+        if(values.empty() && pSlot < this->mConstraints.size()) {
+            values = this->mConstraints[pSlot].mChoicesText;
+        }
+        for(StringView value : CsvRange(values)) {
+            if(value.startsWith(pPrefix)) {
+                pOut.push_back(value);
+            }
+        }
+    }
+
+    /// @brief True if argv asks for completions, and completion is on
+    bool isCompletionRequest(int argc, char const* const* argv) const {
+        return this->mCfgCompletion && argc >= 3 && StringView(argv[1]) == "--__complete";
+    }
+
+    /**
+     * @brief If argv asks for completions, print them, one per line
+     * e.g. 'myProgram --__complete 2 myProgram --verbose --th' prints '--threads'
+     * @return True if it asked, and completion is on
+     */
+    bool printCompletions(int argc, char const* const* argv) const {
+        if(!this->isCompletionRequest(argc, argv)) {
+            return false;
+        }
+        MemoryResource* resource = this->mArgs.get_allocator().mResource;
+        Vector<StringView> words(resource);
+        for(int i = 3; i < argc; i++) {
+            words.push_back(argv[i]);
+        }
+        Vector<StringView> candidates(resource);
+        StringView prefix = this->complete(words.data(), words.size(), (size_t)strtoul(argv[2], NULL, 10), candidates);
+        String out;
+        for(StringView candidate : candidates) {
+            out.append(prefix.data(), prefix.length());
+            out.append(candidate.data(), candidate.length());
+            out += '\n';
+        }
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+        return true;
+    }
+
+    /**
+     * @brief Parse the tokens from pIndex on, the subcommand's name then its arguments, into the
+     * result's subcommand result
+     * @return False if it fails, with pError set
+     */
+    bool parseSubcommand(ArgParserResult &pResult, const Subcommand &pSubcommand, size_t pIndex, ParseError &pError, bool pBind) const {
+        const ArgParser &parser = this->buildSubcommand(pSubcommand);
+        if(!pResult.mSubcommandResult) {
+            pResult.mSubcommandResult.reset(new ArgParserResult(pResult.mSlots.get_allocator().mResource));
+        }
+        ArgParserResult &result = *pResult.mSubcommandResult;
+        result.clear();
+        // The name takes the place of the program's. Views of the same tokens, so nothing's copied
+        result.mTokens.assign(pResult.mTokens.begin() + pIndex, pResult.mTokens.end());
+        result.mParentResult = &pResult;
+        pResult.mSubcommand = pSubcommand.mName;
+        bool isParsed = parser.parseTokens(result, pError, pBind);
+        result.mParentResult = NULL;
+        if(!isParsed && pError.mTokenIndex != ParseError::npos) {
+            pError.mTokenIndex += pIndex;
+        }
+        return isParsed;
+    }
+
+    /**
+     * @brief After matchTokens, fill in the rest of the result: values from other sources, the final
+     * argument and defaults. Checking for missing arguments
+     * @return False if it fails, with pError set
+     */
+    bool completeResult(ArgParserResult &pResult, ParseError &pError, bool pBind) const {
+        const Vector<StringView> &tokens = pResult.mTokens;
+        ArgDefPtr def = NULL;
+        if(pResult.mPositionals.size() < this->mPositionalsMin) {
+            pError.mKind = ErrorKind::MissingArgument;
+            pError.mKey = this->mPositionals->mName;
+            pError.mTokenIndex = ParseError::npos;
+            pError.mPosition = 0;
+            return false;
+        }
+        if(!this->applySources(pResult, pError, pBind)) {
+            return false;
+        }
+        pResult.groupValues();
+        // Configure the mandatory final argument if applicable
+        if(this->mHasFinalArg && !tokens.empty()) {
+            if(pBind && !this->checkBinding(pResult, this->getFinalArgSlot(), this->mArgFinal->mName, tokens.back(), pError)) {
+                pError.mTokenIndex = tokens.size() - 1;
+                pError.mPosition = 0;
+                return false;
+            }
+            this->handleArgPair(pResult, this->getFinalArgSlot(), this->mArgFinal, tokens.back());
+        }
+        // Validate, and fill in the defaults for any missing optional args
+        for(uint32_t i = 0; i < this->mArgs.size(); i++) {
+            if(pResult.mSeen[i]) {
+                continue;
+            }
+            def = this->mArgs[i];
+            uint8_t traits = this->mArgTraits[i];
+            if(!(traits & TraitOptional)) {
+                // Not an optional arg, and it wasn't found
+                pError.mKind = ErrorKind::MissingArgument;
+                pError.mKey = def->mName;
+                pError.mTokenIndex = ParseError::npos;
+                pError.mPosition = 0;
+                return false;
+            }
+            ArgPair &pair = pResult.mSlots[i];
+            pair.mArg = def;
+            // Missing flags are false, and other missing optional args empty
+            pair.mValue = (traits & TraitFlag) ? "false" : "";
+            // Bound flags are set false too. Missing optional args leave their variables as they were
+            if(pBind && (traits & TraitFlag) && this->getBinding(i).mStore != NULL) {
+                ArgParserResult::BoundValue bound = { pair.mValue, 0, i, true };
+                pResult.mBoundValues.push_back(bound);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Fill in the arguments missing from the command line from the environment, or failing that
+     * config files. A repeatable argument takes every value its config file gives, as occurrences in
+     * file order. See loadEnvironment and loadConfigFile
+     * @param pError Set to InvalidValue if a flag's value isn't a bool, or a bound variable's can't be converted
+     * @return False if it fails
+     */
+    bool applySources(ArgParserResult &pResult, ParseError &pError, bool pBind) const {
+        size_t configCount = this->mConfigOffsets.empty() ? 0 : this->mConfigOffsets.size() - 1;
+        size_t count = std::max(this->mEnvValues.size(), configCount);
+        for(uint32_t i = 0; i < count; i++) {
+            if(pResult.mSeen[i]) {
+                continue;
+            }
+            ArgValues values;
+            if(i < this->mEnvValues.size() && !this->mEnvValues[i].empty()) {
+                values.mBegin = &this->mEnvValues[i];
+                values.mEnd = values.mBegin + 1;
+                pResult.mEnvStorage = this->mEnvStorage;
+            } else if(i < configCount && this->mConfigOffsets[i] != this->mConfigOffsets[i + 1]) {
+                values.mBegin = this->mConfigValues.data() + this->mConfigOffsets[i];
+                values.mEnd = this->mConfigValues.data() + this->mConfigOffsets[i + 1];
+            } else {
+                continue;
+            }
+            ArgDefPtr def = this->mArgs[i];
+            for(StringView value : values) {
+                if(value.empty()) {
+                    continue;
+                }
+                // Unlike on the command line, a flag always has a value here
+                if(def->mIsFlag && !NormaliseFlag(value)) {
+                    pError.mKind = ErrorKind::InvalidValue;
+                    pError.mKey = def->mName;
+                    pError.mValue = value;
+                    pError.mConvertError = ConvertError::Invalid;
+                    pError.mTokenIndex = ParseError::npos;
+                    return false;
+                }
+                if(!this->acceptValue(pResult, i, def->mName, value, pError, pBind)) {
+                    pError.mTokenIndex = ParseError::npos;
+                    pError.mPosition = 0;
+                    return false;
+                }
+                if(def->mRepeatable) {
+                    pResult.addOccurrence(i, value);
+                }
+                pResult.setResult(i, def, value);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check a value against the argument's constraints, then that it converts for the variable it's
+     * bound to if pBind. Records which choice it is, if it's the first occurrence
+     * @param pError Set to InvalidValue if it breaks them or can't be converted. The caller sets the token
+     *   index and position
+     * @return False if it does
+     */
+    bool acceptValue(ArgParserResult &pResult, uint32_t slot, StringView key, StringView value, ParseError &pError, bool pBind) const {
+        if((this->mArgTraits[slot] & TraitConstrained) && this->mConstraints[slot].isSet()) {
+            int32_t choice;
+            ConvertError error = this->mConstraints[slot].check(value, choice);
+            if(error != ConvertError::None) {
+                pError.mKind = ErrorKind::InvalidValue;
+                pError.mKey = key;
+                pError.mValue = value;
+                pError.mConvertError = error;
+                return false;
+            }
+            if(!pResult.mSeen[slot]) {
+                pResult.mSlots[slot].mChoice = choice;
+            }
+        }
+        return !pBind || this->checkBinding(pResult, slot, key, value, pError);
+    }
+
+    /// @brief The index of the value among the argument's choices. -1 if it isn't one, or there are none
+    int32_t findChoice(uint32_t slot, StringView value) const {
+        return slot < this->mConstraints.size() ? this->mConstraints[slot].mChoices.find(value) : -1;
+    }
+
+    /**
+     * @brief Convert the value for the variable the argument in the slot is bound to, if any, and record
+     * it for commitBindings. The variable isn't written yet, in case the parse fails later
+     * @param pError Set to InvalidValue if it can't be converted. The caller sets the token index and position
+     * @return False if it can't be converted
+     */
+    bool checkBinding(ArgParserResult &pResult, uint32_t slot, StringView key, StringView value, ParseError &pError) const {
+        const ArgBinding &binding = this->getBinding(slot);
+        if(binding.mStore == NULL) {
+            return true;
+        }
+        ARG_STATS(detail::PhaseTimer timer(pResult.mStats.mConvertNs);)
+        uint64_t converted = 0;
+        ConvertError error = binding.mConvert(value, converted);
+        if(error == ConvertError::None) {
+            ArgParserResult::BoundValue bound = { value, converted, slot, !pResult.mSeen[slot] };
+            pResult.mBoundValues.push_back(bound);
+            return true;
+        }
+        pError.mKind = ErrorKind::InvalidValue;
+        pError.mKey = key;
+        pError.mValue = value;
+        pError.mConvertError = error;
+        return false;
+    }
+
+    /**
+     * @brief Store the values a successful parse converted in the variables their arguments are bound to,
+     * in the order found. Then the subcommand's, in its parser's
+     */
+    void commitBindings(const ArgParserResult &pResult) const {
+        for(const ArgParserResult::BoundValue &bound : pResult.mBoundValues) {
+            const ArgBinding &binding = this->getBinding(bound.mSlot);
+            binding.mStore(binding.mTarget, bound.mValue, bound.mConverted, bound.mFirst);
+        }
+        if(!pResult.mSubcommand.empty()) {
+            uint32_t subcommand = this->mSubcommandIndex.find(pResult.mSubcommand);
+            this->buildSubcommand(*this->mSubcommands[subcommand]).commitBindings(*pResult.mSubcommandResult);
+        }
+    }
+
+public:
+    // Config functions
+
+    /**
+     * @brief Configures the name of the program. Only used in the help string
+     */
+    void setProgramName(String pName) {
+        this->mProgramName = pName;
+        this->mHelpText.reset();
+    }
+
+    /**
+     * @brief Wrap the help at the given width
+     * @param pWidth In columns. 0 (the default) for the terminal's, or $COLUMNS, or 80
+     */
+    void setHelpWidth(size_t pWidth) {
+        this->mHelpWidth = pWidth;
+    }
+
+    /**
+     * @brief Be told about each parse, with what it cost. Only if the library is compiled with
+     * CPP_ARG_PARSER_STATS defined. See ParseObserver
+     * @param pObserver Must outlive the parser, or be replaced first. NULL for none
+     */
+    void setParseObserver(ParseObserver* pObserver) {
+        this->mObserver = pObserver;
+    }
+
+    /// @brief What the parser's own last parse cost. See ParseStats
+    const ParseStats& getStats() const {
+        return this->mResult.mStats;
+    }
+
+    /**
+     * @brief The memory the schema takes, to keep track of it for large generated schemas.
+     * Not the subcommands' parsers: ask those with getSubcommandParser
+     */
+    SchemaFootprint getSchemaFootprint() const {
+        SchemaFootprint footprint;
+        footprint.mArgs = this->mArgs.size();
+        footprint.mDefinitionBytes = this->mOwnedArgCount * sizeof(ArgDef)
+            + this->mSubcommands.size() * sizeof(Subcommand);
+        footprint.mTableBytes = this->mArgs.capacity() * sizeof(ArgDefPtr)
+            + this->mArgTraits.capacity() * sizeof(uint8_t)
+            + this->mNames.capacity() * sizeof(StringView)
+            + this->mNameStart.capacity() * sizeof(uint32_t)
+            + this->mNameChars.capacity() * sizeof(uint64_t)
+            + this->mBindings.capacity() * sizeof(ArgBinding)
+            + this->mEnvVars.capacity() * sizeof(StringView)
+            + this->mValueCompletions.capacity() * sizeof(StringView)
+            + this->mConstraints.capacity() * sizeof(detail::Constraint)
+            + this->mSubcommands.capacity() * sizeof(this->mSubcommands[0]);
+        for(const detail::Constraint &constraint : this->mConstraints) {
+            footprint.mTableBytes += constraint.mChoices.bytes();
+        }
+        footprint.mStringBytes = this->mStrings.bytes();
+        footprint.mStringReservedBytes = this->mStrings.reserved();
+        footprint.mIndexBytes = this->mArgsIndex.bytes() + this->mBareIndex.bytes() + this->mSubcommandIndex.bytes()
+            + this->mStrings.indexBytes();
+        return footprint;
+    }
+
+    /**
+     * @brief Read arguments from response files: each '@path' argument is replaced by the arguments
+     * in the file, separated by whitespace and quoted as in a shell. Files can name other files, but
+     * not themselves. Relative paths are relative to the working directory.
+     * The files are memory-mapped and kept open until the result is next parsed into, or destroyed.
+     * Token indexes in errors count the arguments after expansion, except for the response file errors.
+     * @param pResponseFiles If true, expand response files
+     */
+    void setResponseFiles(bool pResponseFiles) {
+        this->mCfgResponseFiles = pResponseFiles;
+    }
+
+    /**
+     * @brief Will force the parse function to catch exceptions
+     * You can check if the arguments were passed by looking at
+     * the returned boolean from the parse function.
+     * @param pCatchExceptions If true, will catch exceptions in 'parse'
+     */
+    void setCatchExceptions(bool pCatchExceptions) {
+        this->mCfgCatchExceptions = pCatchExceptions;
+    }
+
+    /**
+     * @brief If the exception is caught, will print help messages.
+     * You can enable exception catching through 'setCatchExceptions', and then 
+     * enable printed help messages with this function.
+     * You can of course print the help manually with 'getHelp'
+     * @param pPrintHelpOnCaughtException If true, will print on caught exceptions
+     */
+    void setPrintHelpOnCaughtException(bool pPrintHelpOnCaughtException) {
+        this->mCfgPrintHelpOnCaughtException = pPrintHelpOnCaughtException;
+    }
+
+    /**
+     * @brief Results point straight into the argv given to 'parse' instead of a copy of it.
+     * Saves copying every token, but argv must then outlive the results (it normally
+     * does, being main's argv).
+     * @param pZeroCopy If true, won't copy argv in 'parse'
+     */
+    void setZeroCopy(bool pZeroCopy) {
+        this->mCfgZeroCopy = pZeroCopy;
+    }
+
+    /**
+     * @brief Add an argument that requires a value.
+     * e.g. Not a flag, but something like '--threads 12'
+     * 
+     * @param pName The full name of the argument, including an prefix. e.g. --thread
+     * @param pCSAliases Comma-separated aliases, including prefixes. e.g. "-t,-h"
+     * @param pDesc Description of the parameter
+     * @param opt True if this parameter is optional
+     */
+    void addArg(StringView pName, StringView pCSAliases, StringView pDesc="", bool opt=true) {
+        LOG("Adding Arg (%.*s) -> %.*s\n", (int)pName.length(), pName.data(), (int)pDesc.length(), pDesc.data());
+        this->registerArgDef(this->ownArgDef(pName, pCSAliases, pDesc, opt, false, false));
+    };
+
+    /**
+     * @brief Add an argument that requires a value, and can be given any number of times.
+     * e.g. '--input a.txt --input b.txt'. Read them all with getAll, or bind to a std::vector.
+     * Otherwise the same as addArg
+     */
+    void addRepeatableArg(StringView pName, StringView pCSAliases, StringView pDesc="", bool opt=true) {
+        LOG("Adding Arg (%.*s) -> %.*s\n", (int)pName.length(), pName.data(), (int)pDesc.length(), pDesc.data());
+        this->registerArgDef(this->ownArgDef(pName, pCSAliases, pDesc, opt, false, true));
+    }
+
+    /**
+     * @brief Add an argument that doesn't require a value
+     * e.g. '--enablecolour'. Giving it at all sets it: a value given with it is ignored.
+     * In a LiveArgs change it takes the value, to be turned off. e.g. '--enablecolour=false'
+     * 
+     * @param pName The full name of the argument, including an prefix. e.g. --enablecolour
+     * @param pCSAliases Comma-separated aliases, including prefixes. e.g. "-e,-c"
+     * @param pDesc Description of the parameter
+     */
+    void addFlag(StringView pName, StringView pCSAliases, StringView pDesc="") {
+        LOG("Adding Arg (%.*s) -> %.*s\n", (int)pName.length(), pName.data(), (int)pDesc.length(), pDesc.data());
+        /// Flags are always optional. There presence indices they're true
+        this->registerArgDef(this->ownArgDef(pName, pCSAliases, pDesc, true, true, false));
+    };
+
+    /**
+     * @brief Add a table of argument definitions, without copying them.
+     * The table is normally static, declared with ArgDef::Arg and ArgDef::Flag, so
+     * registering it costs no allocations beyond the parser's own list of arguments.
+     * e.g.
+     *   static constexpr argparse::ArgDef kArgs[] = {
+     *       argparse::ArgDef::Flag("--colour", "-c", "Enable colour"),
+     *       argparse::ArgDef::Arg("--threads", "-t", "Number of threads to use", false),
+     *   };
+     *   static_assert(argparse::ArgDefsAreUnique(kArgs), "Duplicate argument names");
+     *   argParser.addArgs(kArgs);
+     *
+     * @param pDefs The definitions. Must outlive the parser
+     * @param pCount The number of definitions
+     */
+    void addArgs(const ArgDef* pDefs, size_t pCount) {
+        this->mArgs.reserve(this->mArgs.size() + pCount);
+        for(size_t i = 0; i < pCount; i++) {
+            this->registerArgDef(&pDefs[i]);
+        }
+    }
+
+    template<size_t N>
+    void addArgs(const ArgDef (&pDefs)[N]) {
+        this->addArgs(pDefs, N);
+    }
+
+    /**
+     * @brief Add an argument that requires a value, bound to a variable. See bind
+     * e.g. argParser.addArg("--threads", "-t", "Number of threads to use", true, &threads);
+     */
+    template<typename T>
+    void addArg(StringView pName, StringView pCSAliases, StringView pDesc, bool opt, T* pTarget) {
+        this->addArg(pName, pCSAliases, pDesc, opt);
+        this->mBindings.resize(this->mArgs.size());
+        this->bindSlot((uint32_t)(this->mArgs.size() - 1), pTarget);
+    }
+
+    /// @brief Add an optional argument that requires a value, bound to a variable. See bind
+    template<typename T>
+    void addArg(StringView pName, StringView pCSAliases, StringView pDesc, T* pTarget) {
+        this->addArg(pName, pCSAliases, pDesc, true, pTarget);
+    }
+
+    /// @brief Add a flag, bound to a variable. See bind
+    void addFlag(StringView pName, StringView pCSAliases, StringView pDesc, bool* pTarget) {
+        this->addFlag(pName, pCSAliases, pDesc);
+        this->mBindings.resize(this->mArgs.size());
+        this->bindSlot((uint32_t)(this->mArgs.size() - 1), pTarget);
+    }
+
+    /**
+     * @brief Bind an argument to a variable, that parse then converts and stores its value in.
+     * Saves looking the value up and converting it after the parse, and catches bad values
+     * while parsing: they fail it with InvalidValue. The variables are only written once the whole
+     * parse has succeeded, so a failed one leaves them all as they were.
+     *
+     * Numbers are converted as ArgPair::to. bool takes true/yes/on/1 or false/no/off/0, and is
+     * set false for a missing flag. String copies the value, and StringView points to it in the
+     * result. As in the results, the first occurrence of an argument wins, except for a
+     * std::vector of any of those, which collects them all.
+     * A missing optional argument leaves its variable as it was, so initialise it to the default.
+     *
+     * Finalizes the parser if arguments were added since. Bind after adding all of them.
+     * @param pName The name or an alias of the argument, or the name of the final argument
+     * @param pTarget Must outlive the parser. Written by every successful parse, so only one thread may parse at a time
+     * @throw std::invalid_argument If there's no such argument
+     */
+    template<typename T>
+    void bind(StringView pName, T* pTarget) {
+        if(this->mIndexDirty) {
+            this->finalize();
+        }
+        uint32_t slot = this->getArgSlot(pName);
+        if(this->mHasFinalArg && pName == this->mArgFinal->mName) {
+            slot = this->getFinalArgSlot();
+        } else if(slot == ArgIndex::npos) {
+            throw std::invalid_argument("Can't bind unknown argument: " + pName.toString());
+        } else if(this->mBindings.size() <= slot) {
+            this->mBindings.resize(this->mArgs.size());
+        }
+        this->bindSlot(slot, pTarget);
+    }
+
+    /**
+     * @brief Set the mandatory final argument
+     * e.g. 'myProgram --arg1 val1 --arg2=val2 --flag1 FINAL_ARGUMENT'
+     * 
+     * @param pName The full name of the argument
+     * @param pDesc Description of the argument
+     */
+    void setFinalArg(StringView pName, StringView pDesc="") {
+        ArgDefPtr def = this->ownArgDef(ArgDef::Final(this->mStrings.intern(pName), this->mStrings.intern(pDesc)));
+        this->setFinalArg(*def);
+    }
+
+    /**
+     * @brief Set the mandatory final argument, without copying it. See ArgDef::Final
+     * @param pDef The definition. Must outlive the parser
+     */
+    void setFinalArg(const ArgDef &pDef) {
+        this->mHasFinalArg = true;
+        this->mArgFinal = &pDef;
+        this->mHelpText.reset();
+    }
+
+    /**
+     * @brief Accept positional arguments: any that aren't options or their values.
+     * e.g. 'myProgram --arg1 val1 a.txt b.txt --flag1 c.txt -- --d.txt'
+     * Everything after a '--' is positional. Otherwise anything starting with '-' (but not '-' itself)
+     * is taken to be an option. Read them with getPositionals, as views of argv: none are copied
+     * in zero-copy mode. If there's a final argument too, it's still the last one.
+     *
+     * @param pName The name of the arguments. Only used in the help string
+     * @param pDesc Description of the arguments
+     * @param pMin The fewest allowed. Fewer fail the parse with MissingArgument
+     * @param pMax The most allowed. More fail it with UnknownArgument, at the first one too many
+     */
+    void setPositionals(StringView pName, StringView pDesc="", size_t pMin=0, size_t pMax=(size_t)-1) {
+        ArgDefPtr def = this->ownArgDef(ArgDef::Final(this->mStrings.intern(pName), this->mStrings.intern(pDesc)));
+        this->mPositionals = def;
+        this->mPositionalsMin = pMin;
+        this->mPositionalsMax = pMax;
+        this->mHelpText.reset();
+    }
+
+    // Subcommands
+
+    /// The function that adds a subcommand's arguments to its parser. See addSubcommand
+    using SubcommandFactory = std::function<void(ArgParser &pParser)>;
+
+    /**
+     * @brief Add a git-style subcommand. e.g. 'myProgram --verbose commit -m "Message"'
+     * Options before the subcommand's name are this parser's, and everything after is the subcommand's.
+     * Options the subcommand doesn't know are looked up here, so global ones can go anywhere.
+     *
+     * The subcommand's parser isn't built until it's used, so adding hundreds costs little:
+     * only the one given is built, by calling pFactory with the empty parser (once, even across threads).
+     * Read its arguments with getSubcommandResult. A parser with subcommands can't have a final argument.
+     *
+     * @param pName The name of the subcommand. e.g. "commit"
+     * @param pDesc Description of the subcommand, for the help string
+     * @param pFactory Adds the subcommand's arguments to the parser it's given. e.g.
+     *   argParser.addSubcommand("commit", "Record changes", [](argparse::ArgParser &pCommit) {
+     *       pCommit.addArg("--message", "-m", "The commit message", false);
+     *   });
+     */
+    void addSubcommand(StringView pName, StringView pDesc, SubcommandFactory pFactory) {
+        std::unique_ptr<Subcommand> subcommand(new Subcommand());
+        subcommand->mName = this->mStrings.intern(pName);
+        subcommand->mDescription = this->mStrings.intern(pDesc);
+        subcommand->mFactory = std::move(pFactory);
+        this->mSubcommands.push_back(std::move(subcommand));
+        this->mIndexDirty = true;
+        this->mHelpText.reset();
+    }
+
+    /**
+     * @brief Get a subcommand's parser, building it if it hasn't been. e.g. for its help string
+     * @throw std::invalid_argument If there's no such subcommand
+     * @throw std::logic_error If subcommands were added since finalize was last called
+     */
+    const ArgParser& getSubcommandParser(StringView pName) const {
+        if(this->mIndexDirty) {
+            throw std::logic_error("ArgParser::finalize must be called after adding subcommands");
+        }
+        uint32_t subcommand = this->mSubcommandIndex.find(pName);
+        if(subcommand == ArgIndex::npos) {
+            throw std::invalid_argument("No such subcommand: " + pName.toString());
+        }
+        return this->buildSubcommand(*this->mSubcommands[subcommand]);
+    }
+
+    /// @brief The parser this is a subcommand of. NULL if it isn't one
+    const ArgParser* getParent() const {
+        return this->mParent;
+    }
+
+    // Constraints. Checked as values are parsed, from the command line or other sources. A value that
+    // breaks one fails the parse with InvalidValue
+
+    /**
+     * @brief Only allow the given values. Each is given an index, in order: the one given is in ArgPair::mChoice.
+     * Found by a perfect hash, so checking costs a hash and one comparison. Also what it completes to.
+     * See ArgDef::withChoices
+     * @param pName Name or alias of the argument
+     * @param pCSChoices Comma-separated values. e.g. "fast,safe,debug"
+     * @throw std::invalid_argument If there's no such argument, or a choice is repeated
+     */
+    void setChoices(StringView pName, StringView pCSChoices) {
+        detail::Constraint &constraint = this->getConstraint(this->getSlotToConfigure(pName, "choices"));
+        constraint.mChoicesText = this->mStrings.intern(pCSChoices);
+        constraint.mChoices.build(constraint.mChoicesText);
+    }
+
+    /**
+     * @brief Only allow numbers from pMin to pMax, inclusive. See ArgDef::withRange
+     * @throw std::invalid_argument If there's no such argument
+     */
+    void setRange(StringView pName, double pMin, double pMax) {
+        detail::Constraint &constraint = this->getConstraint(this->getSlotToConfigure(pName, "range"));
+        constraint.mHasRange = true;
+        constraint.mMin = pMin;
+        constraint.mMax = pMax;
+    }
+
+    /**
+     * @brief Only allow values matching a glob: '*' for any run of characters, '?' for any one,
+     * '[a-z_]' for one in a class ('[!...]' for one not), and '\\' to escape. e.g. "[0-9]*x[0-9]*"
+     * See ArgDef::withPattern
+     * @throw std::invalid_argument If there's no such argument
+     */
+    void setPattern(StringView pName, StringView pGlob) {
+        detail::Constraint &constraint = this->getConstraint(this->getSlotToConfigure(pName, "pattern"));
+        constraint.mPattern = this->mStrings.intern(pGlob);
+    }
+
+    // Completion
+
+    /**
+     * @brief Answer the hidden '--__complete <word index> <words...>' argument with completions:
+     * parse prints them instead of parsing, and reports it (see isCompleted, ParseError's Completed and
+     * ArgParserResult::mCompleted) for the program to exit. The shell scripts from getCompletionScript
+     * ask it on each TAB. Completes option names, the values given with setCompletions, and subcommands.
+     * @param pCompletion If true, parse answers completions
+     * @param pExit If true, parse(argc, argv) exits the program once it has answered, with status 0.
+     *   The other parse functions never do
+     */
+    void setCompletion(bool pCompletion, bool pExit=false) {
+        this->mCfgCompletion = pCompletion;
+        this->mCfgCompletionExit = pExit;
+    }
+
+    /**
+     * @brief Set the values an argument completes to. e.g. setCompletions("--level", "debug,info,warn")
+     * @param pName Name or alias of the argument
+     * @param pCSValues Comma-separated values
+     * @throw std::invalid_argument If there's no such argument
+     */
+    void setCompletions(StringView pName, StringView pCSValues) {
+        uint32_t slot = this->getSlotToConfigure(pName, "completions");
+        if(this->mValueCompletions.size() <= slot) {
+            this->mValueCompletions.resize(this->mArgs.size());
+        }
+        this->mValueCompletions[slot] = this->mStrings.intern(pCSValues);
+    }
+
+    /**
+     * @brief Complete a word of a command line, the way a shell asks for it.
+     * A value of an option completes to the option's values (see setCompletions), a word starting with
+     * '-' to the options, and anything else to the subcommands. Only the subcommands named in the
+     * command line are built. Doesn't need finalize.
+     *
+     * @param pWords The words of the command line, the program's name first
+     * @param pCount The number of words
+     * @param pCurrent The index of the word to complete. May be pCount, to start a new word
+     * @param pOut The candidates are appended to it, sorted and without the prefix. They're views of
+     *   the definitions
+     * @return The prefix every candidate goes after, if the word is an '--option=value'. e.g. '--option='.
+     *   Empty otherwise
+     */
+    StringView complete(const StringView* pWords, size_t pCount, size_t pCurrent, Vector<StringView> &pOut) const {
+        StringView current = pCurrent < pCount ? pWords[pCurrent] : StringView();
+        StringView prefix, key, val;
+        const ArgParser* parser = this;
+        const ArgParser* owner = NULL;
+        uint32_t slot = 0;
+        // Find the subcommand, and whether the word to complete is a value
+        ArgDefPtr valueOf = NULL;
+        for(size_t i = 1; i < pCurrent && i < pCount; i++) {
+            StringView word = pWords[i];
+            if(valueOf != NULL) {
+                valueOf = NULL;
+            } else if(word == "--") {
+                return prefix; // Only positionals after it
+            } else if(IsOptionLike(word)) {
+                if(!parser->SplitArg(word, key, val)) {
+                    valueOf = parser->findArgForCompletion(word, owner, slot);
+                    valueOf = (valueOf != NULL && !valueOf->mIsFlag) ? valueOf : NULL;
+                }
+            } else {
+                for(const std::unique_ptr<Subcommand> &subcommand : parser->mSubcommands) {
+                    if(word == subcommand->mName) {
+                        parser = &parser->buildSubcommand(*subcommand);
+                        break;
+                    }
+                }
+            }
+        }
+        size_t first = pOut.size();
+        if(valueOf != NULL) {
+            owner->completeValue(slot, current, pOut);
+        } else if(!current.empty() && current[0] == '-') {
+            if(!parser->SplitArg(current, key, val)) {
+                parser->completeName(current, pOut);
+            } else if(parser->findArgForCompletion(key, owner, slot) != NULL) {
+                owner->completeValue(slot, val, pOut);
+                prefix = current.substr(0, current.length() - val.length());
+            }
+        } else {
+            for(const std::unique_ptr<Subcommand> &subcommand : parser->mSubcommands) {
+                if(subcommand->mName.startsWith(current)) {
+                    pOut.push_back(subcommand->mName);
+                }
+            }
+        }
+        std::sort(pOut.begin() + first, pOut.end());
+        pOut.erase(std::unique(pOut.begin() + first, pOut.end()), pOut.end());
+        return prefix;
+    }
+
+    /**
+     * @brief A script that makes a shell complete the program's arguments, by asking it.
+     * Turn completion on with setCompletion, and name the program with setProgramName. e.g.
+     *   myProgram --completion-script bash > /etc/bash_completion.d/myProgram
+     * @param pShell "bash" or "zsh"
+     * @throw std::invalid_argument For any other shell
+     */
+    String getCompletionScript(StringView pShell) const {
+        String function = "_";
+        for(char c : this->mProgramName) {
+            function += isalnum((unsigned char)c) ? c : '_';
+        }
+        function += "_complete";
+        String script;
+        if(pShell == "bash") {
+            script =
+                "FUNCTION() {\n"
+                "    local cur words cword\n"
+                "    if declare -F _get_comp_words_by_ref >/dev/null; then\n"
+                "        _get_comp_words_by_ref -n =: cur words cword\n"
+                "    else\n"
+                "        cur=\"${COMP_WORDS[COMP_CWORD]}\"\n"
+                "        words=(\"${COMP_WORDS[@]}\")\n"
+                "        cword=$COMP_CWORD\n"
+                "    fi\n"
+                "    local IFS=$'\\n'\n"
+                "    COMPREPLY=($(\"${words[0]}\" --__complete \"$cword\" \"${words[@]}\" 2>/dev/null))\n"
+                "    # Bash only replaces what's after the last '=' or ':' in the word\n"
+                "    if [[ \"$cur\" == *[=:]* ]]; then\n"
+                "        local prefix=\"${cur%\"${cur##*[=:]}\"}\"\n"
+                "        COMPREPLY=(\"${COMPREPLY[@]#\"$prefix\"}\")\n"
+                "    fi\n"
+                "}\n"
+                "complete -o default -F FUNCTION PROGRAM\n";
+        } else if(pShell == "zsh") {
+            script =
+                "#compdef PROGRAM\n"
+                "FUNCTION() {\n"
+                "    local -a candidates\n"
+                "    candidates=(\"${(@f)$(\"${words[1]}\" --__complete $((CURRENT - 1)) \"${words[@]}\" 2>/dev/null)}\")\n"
+                "    if [[ -n \"${candidates[1]}\" ]]; then\n"
+                "        compadd -- \"${candidates[@]}\"\n"
+                "    else\n"
+                "        _files\n"
+                "    fi\n"
+                "}\n"
+                "compdef FUNCTION PROGRAM\n";
+        } else {
+            throw std::invalid_argument("Can't make a completion script for shell: " + pShell.toString());
+        }
+        String out;
+        for(size_t pos = 0; pos < script.size();) {
+            if(script.compare(pos, 8, "FUNCTION") == 0) {
+                out += function;
+                pos += 8;
+            } else if(script.compare(pos, 7, "PROGRAM") == 0) {
+                out += this->mProgramName;
+                pos += 7;
+            } else {
+                out += script[pos++];
+            }
+        }
+        return out;
+    }
+
+    // Snapshots
+
+    /**
+     * @brief A hash of everything about the arguments that affects parsing: names, aliases, kinds,
+     * the final argument and positionals. Two parsers with the same fingerprint lay their results
+     * out the same way. Descriptions and bindings aren't included.
+     */
+    uint64_t getFingerprint() const {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](StringView pText) {
+            for(char c : pText) {
+                hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+            }
+            hash = (hash ^ 0xff) * 1099511628211ull; // Separator, so "ab","c" differs from "a","bc"
+        };
+        for(ArgDefPtr def : this->mArgs) {
+            mix(def->mName);
+            mix(def->mAliases);
+            char kind[] = { (char)('0' + def->mOptional), (char)('0' + def->mIsFlag), (char)('0' + def->mRepeatable), '\0' };
+            mix(kind);
+        }
+        mix(this->mHasFinalArg ? this->mArgFinal->mName : "");
+        mix(this->mPositionals != NULL ? this->mPositionals->mName : "");
+        return hash;
+    }
+
+    /**
+     * @brief Serialize a result, for another process to read with ArgSnapshot without parsing again.
+     * The snapshot is position-independent: slot numbers and offsets into one blob of strings.
+     * It's tagged with getFingerprint, so only a parser with the same arguments can read it.
+     * @param pResult A result of parsing with this parser
+     * @throw std::length_error If the result's strings come to 4GB or more
+     */
+    SnapshotBuffer snapshot(const ArgParserResult &pResult) const {
+        const size_t slotCount = pResult.mSlots.size();
+        size_t blobSize = 0;
+        for(const ArgPair &pair : pResult.mSlots) {
+            blobSize += pair.mArg != NULL ? pair.mValue.length() : 0;
+        }
+        for(StringView value : pResult.mValues) {
+            blobSize += value.length();
+        }
+        for(StringView value : pResult.mPositionals) {
+            blobSize += value.length();
+        }
+        if(blobSize >= UINT32_MAX) {
+            throw std::length_error("Result too large to snapshot");
+        }
+
+        SnapshotBuffer out(this->mArgs.get_allocator().mResource);
+        out.resize(detail::SnapshotSize(slotCount, pResult.mValues.size(), pResult.mPositionals.size(), blobSize));
+        detail::SnapshotHeader* header = (detail::SnapshotHeader*)out.data();
+        memcpy(header->mMagic, "ARGSNAP", 8);
+        header->mByteOrder = detail::SnapshotByteOrderMark;
+        header->mVersion = detail::SnapshotVersion;
+        header->mFingerprint = this->getFingerprint();
+        header->mSlotCount = (uint32_t)slotCount;
+        header->mValueCount = (uint32_t)pResult.mValues.size();
+        header->mPositionalCount = (uint32_t)pResult.mPositionals.size();
+        header->mBlobSize = (uint32_t)blobSize;
+
+        detail::SnapshotSlot* slots = (detail::SnapshotSlot*)(header + 1);
+        uint32_t* valueOffsets = (uint32_t*)(slots + slotCount);
+        detail::SnapshotString* values = (detail::SnapshotString*)(valueOffsets + slotCount + 1);
+        detail::SnapshotString* positionals = values + pResult.mValues.size();
+        char* blob = (char*)(positionals + pResult.mPositionals.size());
+        uint32_t blobUsed = 0;
+        auto store = [blob, &blobUsed](StringView pValue) {
+            detail::SnapshotString stored = { blobUsed, (uint32_t)pValue.length() };
+            if(pValue.length() > 0) {
+                memcpy(blob + blobUsed, pValue.data(), pValue.length());
+            }
+            blobUsed += (uint32_t)pValue.length();
+            return stored;
+        };
+
+        for(size_t i = 0; i < slotCount; i++) {
+            const ArgPair &pair = pResult.mSlots[i];
+            slots[i].mValue = pair.mArg != NULL ? store(pair.mValue) : detail::SnapshotString();
+            slots[i].mFlags = (pair.mArg != NULL ? detail::SnapshotHasPair : 0) | (pResult.mSeen[i] ? detail::SnapshotSeen : 0);
+        }
+        for(size_t i = 0; i <= slotCount; i++) {
+            valueOffsets[i] = i < pResult.mValueOffsets.size() ? pResult.mValueOffsets[i] : 0;
+        }
+        for(size_t i = 0; i < pResult.mValues.size(); i++) {
+            values[i] = store(pResult.mValues[i]);
+        }
+        for(size_t i = 0; i < pResult.mPositionals.size(); i++) {
+            positionals[i] = store(pResult.mPositionals[i]);
+        }
+        return out;
+    }
+
+    /// @brief Serialize the parser's own result. See snapshot(const ArgParserResult&)
+    SnapshotBuffer snapshot() const {
+        return this->snapshot(this->mResult);
+    }
+
+    /**
+     * @brief Write a snapshot of the parser's own result to a file, for ArgSnapshot::open
+     * @throw std::runtime_error If it can't be written
+     */
+    void writeSnapshot(const char* pPath) const {
+        SnapshotBuffer data = this->snapshot();
+        FILE* file = fopen(pPath, "wb");
+        if(file == NULL) {
+            throw std::runtime_error(String("Could not open ") + pPath);
+        }
+        size_t written = fwrite(data.data(), 1, data.size(), file);
+        if(fclose(file) != 0 || written != data.size()) {
+            throw std::runtime_error(String("Could not write ") + pPath);
+        }
+    }
+
+    // Other sources of values
+
+    /**
+     * @brief Set the environment variable an argument can also be set by. See also ArgDef::withEnv
+     * @param pName The name or an alias of the argument
+     * @throw std::invalid_argument If there's no such argument
+     */
+    void setEnvVar(StringView pName, StringView pEnvVar) {
+        uint32_t slot = this->getSlotToConfigure(pName, "environment variable");
+        if(this->mEnvVars.size() <= slot) {
+            this->mEnvVars.resize(this->mArgs.size());
+        }
+        this->mEnvVars[slot] = this->mStrings.intern(pEnvVar);
+    }
+
+    /**
+     * @brief Read the values of the arguments' environment variables (see setEnvVar), for parsing to use
+     * where they're missing from the command line.
+     * Scans the environment once, looking each variable up in an index of the ones wanted, rather
+     * than calling getenv per argument. The values are copied into one buffer, so the environment can
+     * change after. Call it again to pick up changes: the buffer is replaced, though results that took
+     * values from the old one keep it alive. Not while parsing.
+     * A flag's variable is a bool: true, yes, on or 1, or false, no, off or 0.
+     */
+    void loadEnvironment() {
+        if(this->mIndexDirty) {
+            this->finalize();
+        }
+        this->mEnvValues.assign(this->mEnvVars.size(), StringView());
+        this->mEnvStorage.reset();
+        ArgIndex wanted(this->mArgs.get_allocator().mResource);
+        wanted.reset(this->mEnvVars.size());
+        for(uint32_t i = 0; i < this->mEnvVars.size(); i++) {
+            if(!this->mEnvVars[i].empty()) {
+                wanted.insert(this->mEnvVars[i], i);
+            }
+        }
+        if(wanted.size() == 0) {
+            return;
+        }
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+        for(char** variable = environ; variable != NULL && *variable != NULL; variable++) {
+            const char* equals = strchr(*variable, '=');
+            if(equals == NULL) {
+                continue;
+            }
+            uint32_t slot = wanted.find(StringView(*variable, equals - *variable));
+            if(slot != ArgIndex::npos && equals[1] != '\0') {
+                this->mEnvValues[slot] = equals + 1;
+            }
+        }
+#else
+        for(uint32_t i = 0; i < this->mEnvVars.size(); i++) {
+            const char* value = this->mEnvVars[i].empty() ? NULL : getenv(this->mEnvVars[i].data());
+            if(value != NULL && value[0] != '\0') {
+                this->mEnvValues[i] = value;
+            }
+        }
+#endif
+        // The values point into the environment for now. Copy them into one buffer, and point into that
+        size_t total = 0;
+        for(StringView value : this->mEnvValues) {
+            total += value.length();
+        }
+        std::shared_ptr<Vector<char>> storage = std::make_shared<Vector<char>>(this->mArgs.get_allocator().mResource);
+        storage->resize(total);
+        size_t offset = 0;
+        for(StringView &value : this->mEnvValues) {
+            if(value.empty()) {
+                continue;
+            }
+            memcpy(storage->data() + offset, value.data(), value.length());
+            value = StringView(storage->data() + offset, value.length());
+            offset += value.length();
+        }
+        this->mEnvStorage = std::move(storage);
+    }
+
+    /**
+     * @brief Read values from a config file, for parsing to use where they're missing from the
+     * command line and environment. Each line is 'key = value', where the key is an argument's name
+     * or alias, with or without its leading dashes. e.g. 'threads = 4' or '--threads=4'.
+     * Values may be quoted with ' or ", and flags' values are bools as in loadEnvironment.
+     * Lines starting with # or ; are comments. '[section]' lines start a section: only keys
+     * outside any section, or in the given one, are read. Unknown keys are ignored, so one file
+     * can configure many programs.
+     *
+     * The file is memory-mapped and kept open, and values are views of it: nothing is copied.
+     * Later lines, and later files, override earlier ones. Except that a repeatable argument keeps
+     * every value a file gives it, in order, as if each were given on the command line. A later file
+     * that gives it replaces them all. Not while parsing.
+     * @param pSection The section to read, as well as the keys outside any section
+     * @throw std::runtime_error If the file can't be read, or a line isn't a key, value or section.
+     *   Nothing is read from the file then
+     */
+    void loadConfigFile(const char* pPath, StringView pSection="") {
+        if(this->mIndexDirty) {
+            this->finalize();
+        }
+        if(this->mBareIndexDirty) {
+            this->buildBareIndex();
+        }
+        MappedFile file;
+        if(!file.open(pPath)) {
+            throw std::runtime_error(String("Can't read config file: ") + pPath);
+        }
+        StringView text = file.view();
+        // The values found, applied only once the whole file has been read without error
+        Vector<std::pair<uint32_t, StringView>> staged(this->mArgs.get_allocator().mResource);
+
+        bool inSection = true;
+        size_t lineNumber = 0;
+        const char* at = text.data();
+        const char* end = at + text.length();
+        while(at < end) {
+            lineNumber++;
+            const char* lineEnd = (const char*)memchr(at, '\n', end - at);
+            if(lineEnd == NULL) {
+                lineEnd = end;
+            }
+            StringView line = Trim(StringView(at, lineEnd - at));
+            at = lineEnd + 1;
+            if(line.empty() || line[0] == '#' || line[0] == ';') {
+                continue;
+            }
+            if(line[0] == '[' && line[line.length() - 1] == ']') {
+                inSection = Trim(line.substr(1, line.length() - 2)) == pSection;
+                continue;
+            }
+            const char* equalsAt = (const char*)memchr(line.data(), '=', line.length());
+            if(equalsAt == NULL) {
+                throw std::runtime_error(String("Config file ") + pPath + " line " + std::to_string(lineNumber) + ": expected key = value");
+            }
+            if(!inSection) {
+                continue;
+            }
+            size_t equals = equalsAt - line.data();
+            StringView key = Trim(line.substr(0, equals));
+            StringView value = Trim(line.substr(equals + 1));
+            if(value.length() >= 2 && (value[0] == '"' || value[0] == '\'') && value[value.length() - 1] == value[0]) {
+                value = value.substr(1, value.length() - 2);
+            }
+            uint32_t slot = key[0] == '-' ? this->getArgSlot(key) : this->mBareIndex.find(key);
+            if(slot != ArgIndex::npos) {
+                staged.push_back(std::make_pair(slot, value));
+            }
+        }
+        // Moving the file keeps its memory where it is, so the views stay valid
+        this->mConfigFiles.push_back(std::move(file));
+        this->mergeConfigValues(staged);
+    }
+
+    /// @brief Forget the values read by loadEnvironment and loadConfigFile, closing the files
+    void clearSources() {
+        this->mEnvValues.clear();
+        this->mEnvStorage.reset();
+        this->mConfigValues.clear();
+        this->mConfigOffsets.clear();
+        this->mConfigFiles.clear();
+    }
+
+    // String utils
 
+private:
     /**
-     * @brief Register the given argument definition in the parser.
-     * Adds it to the list and map. Adds aliases to the map too
+     * @brief Regroup mConfigValues with a file's values, in file order. Each slot the file gives takes the
+     * file's values in place of the earlier files': all of them if it's repeatable, otherwise the last
      */
-    void registerArgDef(ArgDefPtr pArg) {
-        this->mArgs.push_back(pArg);
-        this->mArgsMap.insert(std::make_pair(pArg->mName, pArg));
-        for(const String &str : pArg->mAliases) {
-            this->mArgsMap.insert(std::make_pair(str, pArg));
+    void mergeConfigValues(const Vector<std::pair<uint32_t, StringView>> &pStaged) {
+        MemoryResource* resource = this->mArgs.get_allocator().mResource;
+        uint32_t slotCount = (uint32_t)this->mArgs.size();
+        Vector<uint32_t> given(slotCount, 0, resource);
+        for(const std::pair<uint32_t, StringView> &value : pStaged) {
+            given[value.first] = (this->mArgTraits[value.first] & TraitRepeatable) ? given[value.first] + 1 : 1;
         }
-    };
+        Vector<uint32_t> offsets(slotCount + 1, 0, resource);
+        for(uint32_t slot = 0; slot < slotCount; slot++) {
+            uint32_t count = given[slot];
+            if(count == 0 && slot + 1 < this->mConfigOffsets.size()) {
+                count = this->mConfigOffsets[slot + 1] - this->mConfigOffsets[slot];
+            }
+            offsets[slot + 1] = offsets[slot] + count;
+        }
+        Vector<StringView> values(offsets[slotCount], StringView(), resource);
+        for(uint32_t slot = 0; slot < slotCount; slot++) {
+            if(given[slot] == 0 && offsets[slot + 1] > offsets[slot]) {
+                std::copy(this->mConfigValues.begin() + this->mConfigOffsets[slot],
+                    this->mConfigValues.begin() + this->mConfigOffsets[slot + 1], values.begin() + offsets[slot]);
+            }
+            // Now where the next of the file's values for the slot goes
+            given[slot] = offsets[slot];
+        }
+        for(const std::pair<uint32_t, StringView> &value : pStaged) {
+            uint32_t &at = given[value.first];
+            values[at] = value.second;
+            if(this->mArgTraits[value.first] & TraitRepeatable) {
+                at++;
+            }
+        }
+        this->mConfigValues.swap(values);
+        this->mConfigOffsets.swap(offsets);
+    }
 
-    /**
-     * @brief Get the argument definition given its name or alias.
-     * If it doesn't exist, will throw an UnknownArgument exception
-     * @throw UnknownArgument
-     */
-    ArgDefPtr getArgDef(String key) {
-        if(this->mArgsMap.find(key) == this->mArgsMap.end()) {
-            throw UnknownArgument(key);
+    /// @brief Build mBareIndex: the names and aliases without their leading dashes
+    void buildBareIndex() {
+        this->mBareIndex.reset(this->mArgsIndex.size());
+        for(uint32_t slot = 0; slot < this->mArgs.size(); slot++) {
+            for(uint32_t i = this->mNameStart[slot]; i < this->mNameStart[slot + 1]; i++) {
+                this->mBareIndex.insert(StripDashes(this->mNames[i]), slot);
+            }
         }
-        return this->mArgsMap.at(key);
+        this->mBareIndexDirty = false;
     }
 
-    // Stage 2 - Results after parsing
+    static StringView StripDashes(StringView pName) {
+        size_t start = 0;
+        while(start < pName.length() && pName[start] == '-') {
+            start++;
+        }
+        return pName.substr(start);
+    }
 
-    /// A struct for storing results in. Makes life a bit cleaner
-    ArgParserResult mResult;
+    static StringView Trim(StringView pText) {
+        size_t start = 0, end = pText.length();
+        while(start < end && (pText[start] == ' ' || pText[start] == '\t')) start++;
+        while(end > start && (pText[end - 1] == ' ' || pText[end - 1] == '\t' || pText[end - 1] == '\r')) end--;
+        return pText.substr(start, end - start);
+    }
 
-    /**
-     * @brief Adds the found argument (and its optional value) to the result struct
-     * Does some special case processing for flags
-     */
-    void handleArgPair(ArgDefPtr def, String value) {
-        ArgPairPtr result = ArgPair::Create();
-        result->mArg = def;
-        if(result->mArg->mIsFlag) {
-            result->mValue = "true";
-        } else {
-            result->mValue = value;
+    /// @brief Normalise a flag's value to "true" or "false", for asBool. False if it isn't a bool
+    static bool NormaliseFlag(StringView &pValue) {
+        uint64_t isSet = 0;
+        if(detail::Binder<bool>::Convert(pValue, isSet) != ConvertError::None) {
+            return false;
         }
-        this->mResult.addResult(result);
+        pValue = isSet != 0 ? "true" : "false";
+        return true;
     }
 
-    /**
-     * @brief Finds the first argument pair given an argument definition
-     * @return NULL if not found
-     */
-    ArgPairPtr getArgPairFromArgDef(ArgDefPtr pArgDef) {
-        for(ArgPairPtr &pair : this->mResult.mResults) {
-            if(pair->mArg == pArgDef) {
-                return pair;
-            }
-        }
-        return NULL;
+    /// @brief True if the token looks like an option, rather than a positional argument. e.g. '-v', but not '-'
+    static bool IsOptionLike(StringView pToken) {
+        return pToken.length() > 1 && pToken[0] == '-';
     }
 
     /**
-     * @brief Finds the first argument pair given an argument name
-     * @throw MissingArgument If the arg pair doesn't exist
+     * @brief Split an argument pair, if possible
+     * @param arg The input argument, e.g. '--myarg=true'
+     * @param key The output key string, e.g. '--myarg'
+     * @param val The output value string, e.g. 'true'
+     * @return True if the argument was split, false otherwise
      */
-    ArgPairPtr getArgPairFromArgName(String key) {
-        if(this->mResult.mResultMap.find(key) == this->mResult.mResultMap.end()) {
-            throw MissingArgument(key);
+    bool SplitArg(StringView arg, StringView &key, StringView &val) const {
+        size_t foundAt = arg.find_first_of(this->mArgSplitChar);
+        if(foundAt != StringView::npos) {
+            key = arg.substr(0, foundAt);
+            val = arg.substr(foundAt + 1);
+            return true;
         }
-        return this->mResult.mResultMap.at(key);
+        return false;
     }
 
+};
+
+/// @brief One line of a bulk parse
+struct BulkResult {
+    /// The line number in the input, from 1
+    size_t mLine = 0;
+    /// The text of the line. Points into the input
+    StringView mText;
+    /// The parsed line. Only valid if there's no error
+    ArgParserResult mResult;
+    /// Why the line failed to parse, if it did
+    ParseError mError;
+};
+
+/// @brief A failed line from a bulk parse. Keeps its own copy of the key, as the input may be gone
+struct BulkError {
+    size_t mLine;
+    ErrorKind mKind;
+    size_t mTokenIndex;
+    size_t mPosition;
+    String mKey;
+};
+
+/// @brief The outcome of a bulk parse
+struct BulkSummary {
+    /// The number of non-blank lines parsed
+    size_t mLines = 0;
+    /// Every line that failed, in line order
+    Vector<BulkError> mErrors;
+};
+
+/**
+ * @brief Parses many command lines, one per line of a file, against one parser.
+ * Lines are split into tokens with shell-style quoting (see ShellTokenizer), the first of which
+ * is the executable, just like argv. Blank lines are skipped.
+ * The input is split into chunks, which are parsed in parallel. Errors are recorded per line
+ * rather than thrown. An exception from the callback (or running out of memory) stops the parse, and is
+ * rethrown from parse once every thread has stopped.
+ *
+ * e.g.
+ *   argparse::BulkParser bulk(argParser);
+ *   argparse::BulkSummary summary = bulk.parseFile("invocations.log", [](const argparse::BulkResult &line) {
+ *       if(!line.mError) use(line.mResult["--threads"].asInt());
+ *   });
+ */
+class BulkParser {
 public:
-    ArgParser() {
-        this->mProgramName = "PROGRAM";
-        this->mCfgCatchExceptions = false;
-        this->mCfgPrintHelpOnCaughtException = true;
+    /// The order results are handed to the callback in
+    enum Order {
+        Ordered,    ///< Line order
+        Unordered   ///< Whichever chunk finishes first. Lines within a chunk are still in order
+    };
+    /// Called once per non-blank line. Never called from two threads at once
+    using Callback = std::function<void(const BulkResult&)>;
+
+private:
+    const ArgParser &mParser;
+    size_t mThreadCount;
+    size_t mChunkSize = 1 << 20;
+    Order mOrder = Ordered;
+
+    /// Used for Chunk::mLineCount until the chunk's lines have been counted
+    static const size_t Uncounted = (size_t)-1;
+
+    /// A piece of the input, starting and ending on line boundaries
+    struct Chunk {
+        StringView mText;
+        /// The number of newlines in it, counted by the worker that parses it. Uncounted until then
+        size_t mLineCount;
     };
 
+    /// @brief Split the input into chunks of about mChunkSize
+    Vector<Chunk> split(StringView pInput) const {
+        Vector<Chunk> chunks;
+        size_t start = 0;
+        while(start < pInput.length()) {
+            size_t end = start + this->mChunkSize;
+            if(end >= pInput.length()) {
+                end = pInput.length();
+            } else {
+                const char* newline = (const char*)memchr(pInput.data() + end, '\n', pInput.length() - end);
+                end = newline == NULL ? pInput.length() : (size_t)(newline - pInput.data()) + 1;
+            }
+            Chunk chunk = { pInput.substr(start, end - start), Uncounted };
+            chunks.push_back(chunk);
+            start = end;
+        }
+        return chunks;
+    }
+
     /**
-     * @brief Creates a help string for the configured arg parser
+     * @brief Run pTask once for each index below pCount, in increasing order, spread over the worker threads
+     * pTask is also given the number of the worker running it, below getWorkerCount(pCount).
+     * It mustn't throw. If threads can't be started, runs on fewer
      */
-    String getHelp() {
-        std::stringstream ss;
-        ss << "Example Command: \n";
-        ss << "  " << this->getExampleCommand() << "\n\n";
-        
-        for(ArgDefPtr &def : this->mArgs) {
-            ss << "  " << def->mName;
-            for(const String &alias : def->mAliases) {
-                ss << ", " << alias;
+    void runWorkers(size_t pCount, const std::function<void(size_t, size_t)> &pTask) const {
+        std::atomic<size_t> next(0);
+        auto work = [&](size_t worker) {
+            for(size_t index = next++; index < pCount; index = next++) {
+                pTask(index, worker);
             }
-            if(!def->mIsFlag) {
-                ss << " <value>";
+        };
+        size_t workerCount = this->getWorkerCount(pCount);
+        Vector<std::thread> threads;
+        threads.reserve(workerCount);
+        for(size_t i = 1; i < workerCount; i++) {
+            try {
+                threads.push_back(std::thread(work, i));
+            } catch(const std::system_error&) {
+                break;
             }
-            ss << "\n    " << def->mDescription;
-            if(!def->mIsFlag) {
-                ss << (def->mOptional?": Optional":": Mandatory");
-            };
-            ss << "\n\n";
         }
-        if(this->mHasFinalArg) {
-            ss << "  " << this->mArgFinal->mName;
-            ss << "\n    " << this->mArgFinal->mDescription << "\n\n";
+        work(0);
+        for(std::thread &thread : threads) {
+            thread.join();
         }
-        return ss.str();
     }
 
-    /**
-     * @brief Creates an example command for the configured arg parser
-     */
-    String getExampleCommand() {
-        std::stringstream ss;
-        ss << this->mProgramName << " ";
-        
-        for(ArgDefPtr &def : this->mArgs) {
-            if(def->mIsFlag) {
-                ss << "[" << def->mName << "] "; 
-            } else if(def->mOptional) {
-                ss << "[" << def->mName << " <value>] "; 
-            } else {
-                ss << "<" << def->mName << " <value>> "; 
-            }
+    size_t getWorkerCount(size_t pTaskCount) const {
+        return std::max((size_t)1, std::min(this->mThreadCount, pTaskCount));
+    }
+
+    /// @brief Tokenize and parse the text of pLine into the rest of it
+    void parseLine(BulkResult &pLine) const {
+        ArgParserResult &result = pLine.mResult;
+        result.clear();
+        ARG_STATS(result.mStats = ParseStats();)
+        pLine.mError = ParseError();
+        result.mStorage.resize(pLine.mText.length());
+        char* scratch = result.mStorage.data();
+        ShellTokenizer tokenizer(pLine.mText);
+        StringView token;
+        ShellTokenizer::Status status;
+        while((status = tokenizer.next(token, scratch)) == ShellTokenizer::Token) {
+            result.mTokens.push_back(token);
         }
-        if(this->mHasFinalArg) {
-            ss << this->mArgFinal->mName;
+        if(status == ShellTokenizer::UnterminatedQuote) {
+            pLine.mError.mKind = ErrorKind::UnterminatedQuote;
+            pLine.mError.mTokenIndex = result.mTokens.size();
+            pLine.mError.mPosition = tokenizer.position();
+            return;
+        }
+        this->mParser.parseTokens(result, pLine.mError, false);
+    }
+
+    static bool IsBlank(StringView pLine) {
+        for(char c : pLine) {
+            if(c != ' ' && c != '\t' && c != '\r') return false;
         }
-        return ss.str();
+        return true;
     }
+
+public:
     /**
-     * @brief Get the argument pair given the argument name.
-     * @throw MissingArgument if the pair doesn't exist
+     * @param pParser The schema to parse against. Must be finalized, and outlive the BulkParser and its results
      */
-    const ArgPair& operator[](const char* key) {
-        ArgPairPtr def = this->getArgPairFromArgName(key);
-        return *def;
-    };
+    explicit BulkParser(const ArgParser &pParser) : mParser(pParser) {
+        this->mThreadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
 
-    // Parsing functions
+    /// @brief How many threads to parse on. Defaults to one per core
+    void setThreadCount(size_t pThreadCount) {
+        this->mThreadCount = pThreadCount > 0 ? pThreadCount : 1;
+    }
+
+    /// @brief Roughly how many bytes of input each thread takes at a time. Defaults to 1MB
+    void setChunkSize(size_t pChunkSize) {
+        this->mChunkSize = pChunkSize > 0 ? pChunkSize : 1;
+    }
+
+    /// @brief The order lines are handed to the callback in. Defaults to Ordered
+    void setOrder(Order pOrder) {
+        this->mOrder = pOrder;
+    }
 
     /**
-     * @brief Parse the command line arguments, validating them too
-     * Finds all arguments and flags. If a non-optional argument is missing,
-     * will throw a MissingArgument exception. If an optional argument is missing,
-     * will populate the result with an empty string for the argument.
-     * If there is an argument without a value, will throw 'MissingValue' exception.
-     * 
-     * If configured, will catch the exceptions instead, and only return true/false
-     * If configured, will print help / error messages to stdout and stderr.
+     * @brief Parse every line of the given text
+     * @param pCallback Called with each non-blank line. May be empty
+     * @throw std::logic_error If the parser hasn't been finalized since arguments were added
+     * @throw Whatever pCallback throws, once every thread has stopped
      */
-    bool parse(int argc, char const* const* argv) {
-        try {
-            this->mResult.clear();
-
-            int firstArgIndex = 1; // Skip the first arg, usually the executable
-            int lastArgIndex = argc;
-            if(this->mHasFinalArg) {
-                lastArgIndex--;
-            }
-
-            String key, val;
-            ArgDefPtr def = NULL;
-            bool isKey = true, isDone = false;
-            // For every valid argument, find the key-value pair. Or just 'key' if it's a flag.
-            for(int i = firstArgIndex; i < lastArgIndex; i++) {
-                String component = String(argv[i]);
-                
-                LOG("Handling %s\n", component.c_str());
-
-                if(isKey) {
-                    if(SplitArg(component, key, val)) {
-                        def = this->getArgDef(key);
-                        isDone = true;
-                    } else {
-                        key = component;
-                        def = this->getArgDef(key);
-                        // If it's a flag. e.g. it's existence determines its value
-                        if(def->mIsFlag) {
-                            isDone = true;
-                        } else {
-                            isKey = false;
+    BulkSummary parse(StringView pInput, const Callback &pCallback=Callback()) const {
+        if(this->mParser.mIndexDirty) {
+            throw std::logic_error("ArgParser::finalize must be called after adding arguments, before parsing");
+        }
+        Vector<Chunk> chunks = this->split(pInput);
+        Vector<BulkSummary> summaries(chunks.size());
+        // Each worker's results for its current chunk. Reused from chunk to chunk, along with their buffers
+        Vector<Vector<BulkResult>> workerLines(this->getWorkerCount(chunks.size()));
+        // Guards the chunks' line counts, nextToDeliver and failure, and the callback
+        std::mutex mutex;
+        std::condition_variable delivered;
+        size_t nextToDeliver = 0;
+        // The first exception thrown. Once there is one, the rest of the chunks are skipped
+        std::exception_ptr failure;
+        std::atomic<bool> isFailed(false);
+
+        this->runWorkers(chunks.size(), [&](size_t index, size_t worker) {
+            Chunk &chunk = chunks[index];
+            // Counted first, as every later chunk needs it to number its lines. Chunks are taken in order,
+            // so the counts of the ones before this are all being counted, and never wait
+            size_t lineCount = std::count(chunk.mText.begin(), chunk.mText.end(), '\n');
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                chunk.mLineCount = lineCount;
+            }
+            delivered.notify_all();
+
+            Vector<BulkResult> &lines = workerLines[worker];
+            BulkSummary &summary = summaries[index];
+            size_t count = 0;
+            try {
+                if(lines.empty()) {
+                    lines.resize(64);
+                }
+                // Numbered from 0 within the chunk, until the chunk's first line number is known
+                size_t lineNumber = 0;
+                size_t start = 0;
+                StringView text = chunk.mText;
+                while(start < text.length() && !isFailed) {
+                    const char* newline = (const char*)memchr(text.data() + start, '\n', text.length() - start);
+                    size_t end = newline == NULL ? text.length() : (size_t)(newline - text.data());
+                    StringView lineText = text.substr(start, end - start);
+                    start = end + 1;
+                    if(!IsBlank(lineText)) {
+                        if(count == lines.size()) {
+                            lines.resize(count * 2);
+                        }
+                        BulkResult &line = lines[count++];
+                        line.mLine = lineNumber;
+                        line.mText = lineText;
+                        this->parseLine(line);
+                        if(line.mError) {
+                            const ParseError &error = line.mError;
+                            BulkError bulkError = { lineNumber, error.mKind, error.mTokenIndex, error.mPosition, error.mKey.toString() };
+                            summary.mErrors.push_back(bulkError);
                         }
                     }
-                } else {
-                    val = component;
-                    isDone = true;
-                    isKey = true;
-                }
-
-                if(isDone) {
-                    isDone = false;
-                    LOG("Got: (%s) -> (%s)\n", key.c_str(), val.c_str());
-                    this->handleArgPair(def, val);
-                    key = "";
-                    val = "";
-                    def = NULL;
-                }
-            }
-            // We found a key but not value for it. Must be missing something
-            if(!isKey) {
-                throw MissingValue(key);
-            }
-            // Configure the mandatory final argument if applicable
-            if(this->mHasFinalArg) {
-                String finalArg = String(argv[argc-1]);
-                this->handleArgPair(this->mArgFinal, finalArg);
-            }
-            // Validate
-            for(ArgDefPtr &def : this->mArgs) {
-                if(!def->mOptional) {
-                    // Not an optional arg, validate then that it has been found
-                    ArgPairPtr found = this->getArgPairFromArgDef(def);
-                    if(found == NULL) {
-                        throw MissingArgument(def->mName);
-                    }
-                } else if(def->mIsFlag) {
-                    ArgPairPtr found = this->getArgPairFromArgDef(def);
-                    if(found == NULL) {
-                        // Add missing flags (just fudge it mate) with value of false
-                        ArgPairPtr fudge = ArgPair::Create();
-                        fudge->mArg = def;
-                        fudge->mValue = "false";
-                        this->mResult.addResult(fudge);
-                    }
-                } else if(def->mOptional) {
-                    ArgPairPtr found = this->getArgPairFromArgDef(def);
-                    if(found == NULL) {
-                        // Fudge an empty parameter
-                        ArgPairPtr fudge = ArgPair::Create();
-                        fudge->mArg = def;
-                        fudge->mValue = "";
-                        this->mResult.addResult(fudge);
-                    }
+                    lineNumber++;
                 }
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!failure) {
+                    failure = std::current_exception();
+                }
+                isFailed = true;
             }
-            return true; // Success
+            summary.mLines = count;
 
-            // Catch errors
-        } catch(const UnknownArgument &except) {
-            if(this->mCfgCatchExceptions) {
-                if(this->mCfgPrintHelpOnCaughtException) {
-                    fprintf(stderr, "Error: Unknown argument provided: %s\n", except.getKey().c_str());
+            // Always taken, and nextToDeliver always advanced, so a failure doesn't leave the others waiting
+            std::unique_lock<std::mutex> lock(mutex);
+            delivered.wait(lock, [&]() {
+                if(this->mOrder == Ordered) {
+                    return nextToDeliver == index;
                 }
-            } else {
-                throw except;
-            }
-        } catch(const MissingArgument &except) {
-            if(this->mCfgCatchExceptions) {
-                if(this->mCfgPrintHelpOnCaughtException) {
-                    fprintf(stderr, "Error: Required argument %s is missing\n", except.getKey().c_str());
+                for(size_t i = 0; i < index; i++) {
+                    if(chunks[i].mLineCount == Uncounted) return false;
                 }
-            } else {
-                throw except;
+                return true;
+            });
+            size_t firstLine = 1;
+            for(size_t i = 0; i < index; i++) {
+                firstLine += chunks[i].mLineCount;
             }
-        } catch(const MissingValue &except) {
-            if(this->mCfgCatchExceptions) {
-                if(this->mCfgPrintHelpOnCaughtException) {
-                    fprintf(stderr, "Error: Last argument %s is missing corresponding value\n", except.getKey().c_str());
-                    if(this->mHasFinalArg) {
-                        fprintf(stderr, "  Hint: Did you forget the final argument '%s'?\n", this->mArgFinal->mName.c_str());
+            for(BulkError &error : summary.mErrors) {
+                error.mLine += firstLine;
+            }
+            try {
+                for(size_t i = 0; i < count && !isFailed; i++) {
+                    lines[i].mLine += firstLine;
+                    if(pCallback) {
+                        pCallback(lines[i]);
                     }
                 }
-            } else {
-                throw except;
+            } catch(...) {
+                if(!failure) {
+                    failure = std::current_exception();
+                }
+                isFailed = true;
             }
+            nextToDeliver++;
+            lock.unlock();
+            delivered.notify_all();
+        });
+        if(failure) {
+            std::rethrow_exception(failure);
         }
-        if(this->mCfgPrintHelpOnCaughtException) {
-            printf("%s", this->getHelp().c_str());
+
+        BulkSummary total;
+        for(BulkSummary &summary : summaries) {
+            total.mLines += summary.mLines;
+            total.mErrors.insert(total.mErrors.end(), summary.mErrors.begin(), summary.mErrors.end());
         }
+        return total;
+    }
 
-        return false; // Something went wrong
+    /**
+     * @brief Parse every line of the file at the given path. The file is memory-mapped where possible
+     * The results refer into the file, so are only valid within the callback
+     * @throw std::runtime_error If the file can't be opened
+     */
+    BulkSummary parseFile(const char* pPath, const Callback &pCallback=Callback()) const {
+        MappedFile file;
+        if(!file.open(pPath)) {
+            throw std::runtime_error(String("Could not open ") + pPath);
+        }
+        return this->parse(file.view(), pCallback);
     }
+};
 
-    // Config functions
+/**
+ * @brief A result read straight from a snapshot (see ArgParser::snapshot), without parsing.
+ * e.g. in a worker process, given the same arguments as the parser that wrote it:
+ *   argparse::ArgSnapshot args(argParser);
+ *   args.open("/dev/shm/myprogram.args");
+ *   int threads = args["--threads"].asInt();
+ *
+ * Nothing is deserialized: opening checks the header, and each lookup reads the snapshot in place.
+ */
+class ArgSnapshot {
+    const ArgParser &mParser;
+    MappedFile mFile;
+    const detail::SnapshotHeader* mHeader = NULL;
+    const detail::SnapshotSlot* mSlots = NULL;
+    const uint32_t* mValueOffsets = NULL;
+    const detail::SnapshotString* mValues = NULL;
+    const detail::SnapshotString* mPositionals = NULL;
+    const char* mBlob = NULL;
+
+    /// @brief The string, checked against the blob as the snapshot may be corrupt
+    StringView getString(const detail::SnapshotString &pString) const {
+        if(pString.mOffset > this->mHeader->mBlobSize || pString.mLength > this->mHeader->mBlobSize - pString.mOffset) {
+            throw std::runtime_error("Corrupt argument snapshot");
+        }
+        return StringView(this->mBlob + pString.mOffset, pString.mLength);
+    }
+
+    uint32_t getSlot(StringView key) const {
+        this->checkAttached();
+        bool isFinal = this->mParser.mHasFinalArg && key == this->mParser.mArgFinal->mName;
+        uint32_t slot = isFinal ? this->mParser.getFinalArgSlot() : this->mParser.getArgSlot(key);
+        if(slot >= this->mHeader->mSlotCount || !(this->mSlots[slot].mFlags & detail::SnapshotHasPair)) {
+            throw MissingArgument(key.toString());
+        }
+        return slot;
+    }
+
+    void checkAttached() const {
+        if(this->mHeader == NULL) {
+            throw std::logic_error("ArgSnapshot used before open or attach");
+        }
+    }
+
+public:
+    /// @brief A range of strings in the snapshot. e.g. for(argparse::StringView value : args.getAll("--input"))
+    class Values {
+        const ArgSnapshot* mSnapshot = NULL;
+        const detail::SnapshotString* mBegin = NULL;
+        size_t mSize = 0;
+        friend class ArgSnapshot;
+    public:
+        class Iterator {
+            const ArgSnapshot* mSnapshot;
+            const detail::SnapshotString* mAt;
+        public:
+            Iterator(const ArgSnapshot* pSnapshot, const detail::SnapshotString* pAt) : mSnapshot(pSnapshot), mAt(pAt) {}
+            StringView operator*() const { return this->mSnapshot->getString(*this->mAt); }
+            Iterator& operator++() { this->mAt++; return *this; }
+            bool operator!=(const Iterator &pOther) const { return this->mAt != pOther.mAt; }
+        };
+        Iterator begin() const { return Iterator(this->mSnapshot, this->mBegin); }
+        Iterator end() const { return Iterator(this->mSnapshot, this->mBegin + this->mSize); }
+        size_t size() const { return this->mSize; }
+        bool empty() const { return this->mSize == 0; }
+        StringView operator[](size_t pIndex) const { return this->mSnapshot->getString(this->mBegin[pIndex]); }
+    };
+
+    /// @param pParser Must have been given the same arguments as the one that wrote the snapshot, and finalized
+    explicit ArgSnapshot(const ArgParser &pParser) : mParser(pParser) {}
+    ArgSnapshot(const ArgSnapshot&) = delete;
+    ArgSnapshot& operator=(const ArgSnapshot&) = delete;
 
     /**
-     * @brief Configures the name of the program. Only used in the help string
+     * @brief Map the snapshot file at the given path, and use it
+     * @throw std::runtime_error If it can't be read, isn't a snapshot, or is from a parser with different arguments
      */
-    void setProgramName(String pName) {
-        this->mProgramName = pName;
+    void open(const char* pPath) {
+        MappedFile file;
+        if(!file.open(pPath)) {
+            throw std::runtime_error(String("Could not open ") + pPath);
+        }
+        StringView data = file.view();
+        this->attach(data.data(), data.length());
+        this->mFile = std::move(file);
     }
 
     /**
-     * @brief Will force the parse function to catch exceptions
-     * You can check if the arguments were passed by looking at
-     * the returned boolean from the parse function.
-     * @param pCatchExceptions If true, will catch exceptions in 'parse'
+     * @brief Use a snapshot that's already in memory. e.g. shared memory mapped by the caller
+     * @param pData Aligned for detail::SnapshotHeader (8 bytes), as new, mmap and ArgParser::snapshot give. Must outlive this
+     * @throw std::runtime_error If it isn't a snapshot, or is from a parser with different arguments
      */
-    void setCatchExceptions(bool pCatchExceptions) {
-        this->mCfgCatchExceptions = pCatchExceptions;
+    void attach(const void* pData, size_t pSize) {
+        if(this->mParser.mIndexDirty) {
+            throw std::logic_error("ArgParser::finalize must be called before reading a snapshot");
+        }
+        this->mHeader = NULL;
+        const detail::SnapshotHeader* header = (const detail::SnapshotHeader*)pData;
+        if(pSize < sizeof(detail::SnapshotHeader) || ((uintptr_t)pData & (alignof(detail::SnapshotHeader) - 1)) != 0 || memcmp(header->mMagic, "ARGSNAP", 8) != 0) {
+            throw std::runtime_error("Not an argument snapshot");
+        }
+        if(header->mByteOrder != detail::SnapshotByteOrderMark || header->mVersion != detail::SnapshotVersion) {
+            throw std::runtime_error("Argument snapshot from an incompatible version or platform");
+        }
+        if(header->mFingerprint != this->mParser.getFingerprint()) {
+            throw std::runtime_error("Argument snapshot from a parser with different arguments");
+        }
+        if(detail::SnapshotSize(header->mSlotCount, header->mValueCount, header->mPositionalCount, header->mBlobSize) != pSize) {
+            throw std::runtime_error("Corrupt argument snapshot");
+        }
+        this->mFile.close();
+        this->mHeader = header;
+        this->mSlots = (const detail::SnapshotSlot*)(header + 1);
+        this->mValueOffsets = (const uint32_t*)(this->mSlots + header->mSlotCount);
+        this->mValues = (const detail::SnapshotString*)(this->mValueOffsets + header->mSlotCount + 1);
+        this->mPositionals = this->mValues + header->mValueCount;
+        this->mBlob = (const char*)(this->mPositionals + header->mPositionalCount);
     }
 
     /**
-     * @brief If the exception is caught, will print help messages.
-     * You can enable exception catching through 'setCatchExceptions', and then 
-     * enable printed help messages with this function.
-     * You can of course print the help manually with 'getHelp'
-     * @param pPrintHelpOnCaughtException If true, will print on caught exceptions
+     * @brief Get the argument pair given the argument name. As ArgParserResult::operator[]
+     * @throw MissingArgument if the pair doesn't exist
      */
-    void setPrintHelpOnCaughtException(bool pPrintHelpOnCaughtException) {
-        this->mCfgPrintHelpOnCaughtException = pPrintHelpOnCaughtException;
+    ArgPair operator[](const char* key) const {
+        uint32_t slot = this->getSlot(key);
+        ArgPair pair;
+        pair.mArg = slot == this->mParser.getFinalArgSlot() ? this->mParser.mArgFinal : this->mParser.mArgs[slot];
+        pair.mValue = this->getString(this->mSlots[slot].mValue);
+        pair.mChoice = this->mParser.findChoice(slot, pair.mValue);
+        return pair;
     }
 
     /**
-     * @brief Add an argument that requires a value.
-     * e.g. Not a flag, but something like '--threads 12'
-     * 
-     * @param pName The full name of the argument, including an prefix. e.g. --thread
-     * @param pCSAliases Comma-separated aliases, including prefixes. e.g. "-t,-h"
-     * @param pDesc Description of the parameter
-     * @param opt True if this parameter is optional
+     * @brief Get every value of an argument given its name. As ArgParserResult::getAll
+     * @throw MissingArgument if there's no such argument
      */
-    void addArg(String pName, String pCSAliases, String pDesc="", bool opt=true) {
-        LOG("Adding Arg (%s) -> %s\n", pName.c_str(), pDesc.c_str());
-        ArgDefPtr arg = ArgDef::Create();
-        arg->mName = pName;
-        SplitCsvStr(pCSAliases, arg->mAliases);
-        arg->mDescription = pDesc;
-        arg->mOptional = opt;
-        arg->mIsFlag = false;
+    Values getAll(const char* key) const {
+        uint32_t slot = this->getSlot(key);
+        Values values;
+        values.mSnapshot = this;
+        bool isRepeatable = slot < this->mParser.mArgs.size() && this->mParser.mArgs[slot]->mRepeatable;
+        if(isRepeatable) {
+            uint32_t begin = this->mValueOffsets[slot], end = this->mValueOffsets[slot + 1];
+            if(begin > end || end > this->mHeader->mValueCount) {
+                throw std::runtime_error("Corrupt argument snapshot");
+            }
+            values.mBegin = this->mValues + begin;
+            values.mSize = end - begin;
+        } else if(this->mSlots[slot].mFlags & detail::SnapshotSeen) {
+            values.mBegin = &this->mSlots[slot].mValue;
+            values.mSize = 1;
+        }
+        return values;
+    }
 
-        this->registerArgDef(arg);
-    };
+    /// @brief Get the positional arguments. As ArgParserResult::getPositionals
+    Values getPositionals() const {
+        this->checkAttached();
+        Values values;
+        values.mSnapshot = this;
+        values.mBegin = this->mPositionals;
+        values.mSize = this->mHeader->mPositionalCount;
+        return values;
+    }
+};
 
-    /**
-     * @brief Add an argument that doesn't require a value
-     * e.g. '--enablecolour'
-     * 
-     * @param pName The full name of the argument, including an prefix. e.g. --enablecolour
-     * @param pCSAliases Comma-separated aliases, including prefixes. e.g. "-e,-c"
-     * @param pDesc Description of the parameter
-     */
-    void addFlag(String pName, String pCSAliases, String pDesc="") {
-        LOG("Adding Arg (%s) -> %s\n", pName.c_str(), pDesc.c_str());
-        ArgDefPtr arg = ArgDef::Create();
-        arg->mName = pName;
-        SplitCsvStr(pCSAliases, arg->mAliases);
-        arg->mDescription = pDesc;
-        arg->mOptional = true; /// Flags are always optional. There presence indices they're true
-        arg->mIsFlag = true;
+/**
+ * @brief Arguments that can be changed while the program runs, e.g. by commands over a control socket,
+ * and read from any thread meanwhile. e.g.
+ *   argparse::LiveArgs args(argParser);
+ *   args.parse(argc, argv);
+ *   args.onChange("--threads", [](argparse::ArgPair pOld, argparse::ArgPair pNew) { resize(pNew.asInt()); });
+ *   args.apply("--threads 8 --mode fast --verbose=false");  // From the control socket
+ *   args.unset("--mode");
+ *   int threads = (*args.get())["--threads"].asInt();  // On any thread
+ *
+ * A change gives some of the arguments, and may unset others. They replace the current values of those
+ * arguments and the rest are kept. Unlike in a full parse, a flag in a change takes the value it's given
+ * (true, yes, on or 1, or false, no, off or 0), so it can be turned off, e.g. --verbose=false. Unset
+ * arguments go back to their other sources (the environment and config files) or their defaults.
+ * The merged arguments are checked like a full parse, then published as a new result, all at once:
+ * readers never block, and never see a change half made. Callbacks are only called for the arguments
+ * whose values changed.
+ *
+ * Values from the environment and config files are fixed at the first parse: they're carried forward
+ * like the rest, so reloading the sources only takes effect through the next parse.
+ * Bound variables (see ArgParser::bind) aren't written: watch for changes with onChange instead.
+ * The final argument can't be changed. Not for parsers with subcommands.
+ * Changes and the results they publish come from DefaultResource, whatever the parser's resource, so
+ * they're freed once replaced even if the parser allocates from an Arena.
+ */
+class LiveArgs {
+public:
+    /// Called with an argument's old and new values when a change is applied
+    using ChangeCallback = std::function<void(ArgPair pOld, ArgPair pNew)>;
 
-        this->registerArgDef(arg);
-    };
+private:
+    const ArgParser &mParser;
+    /// The current arguments. Only read and replaced through std::atomic_load and std::atomic_store
+    std::shared_ptr<const ArgParserResult> mCurrent;
+    /// Held while applying a change, so they're applied one at a time, and their callbacks called in order
+    std::mutex mMutex;
+    /// The callbacks, and the slots of the arguments they watch
+    std::vector<std::pair<uint32_t, ChangeCallback>> mCallbacks;
+    /// The last change's arguments, and the result of merging it if that failed. Kept for the error to refer to
+    ArgParserResult mChange;
+    std::shared_ptr<ArgParserResult> mRejected;
+    /// The slots of the arguments the change unsets, and whether it unsets the positionals
+    std::vector<bool> mUnset;
+    bool mUnsetPositionals = false;
 
     /**
-     * @brief Set the mandatory final argument
-     * e.g. 'myProgram --arg1 val1 --arg2=val2 --flag1 FINAL_ARGUMENT'
-     * 
-     * @param pName The full name of the argument
-     * @param pDesc Description of the argument
+     * @brief Where each change and the results it publishes are allocated. Not the parser's resource:
+     * changes go on for as long as the program runs, and that may be an Arena, which never frees them
      */
-    void setFinalArg(String pName, String pDesc="") {
-        ArgDefPtr arg = ArgDef::Create();
-        arg->mName = pName;
-        arg->mDescription = pDesc;
-        arg->mOptional = false;
-        arg->mIsFlag = false;
+    static MemoryResource* GetResource() {
+        return DefaultResource();
+    }
 
-        this->mHasFinalArg = true;
-        this->mArgFinal = arg;
+    /// @brief True if the argument in the slot has different values in the two results
+    static bool IsChanged(const ArgParserResult &pOld, const ArgParserResult &pNew, uint32_t slot) {
+        if(pOld.mSeen[slot] != pNew.mSeen[slot] || pOld.mSlots[slot].mValue != pNew.mSlots[slot].mValue) {
+            return true;
+        }
+        ArgValues oldValues = pOld.getSlotValues(slot);
+        ArgValues newValues = pNew.getSlotValues(slot);
+        return oldValues.size() != newValues.size() || !std::equal(oldValues.begin(), oldValues.end(), newValues.begin());
     }
 
-    // String utils
+    /// @brief Make pNext the current arguments, then call the callbacks of those that changed from pPrevious
+    void publish(const std::shared_ptr<const ArgParserResult> &pPrevious, std::shared_ptr<const ArgParserResult> pNext) {
+        std::atomic_store(&this->mCurrent, pNext);
+        this->mRejected.reset();
+        if(!pPrevious) {
+            return;
+        }
+        for(const std::pair<uint32_t, ChangeCallback> &callback : this->mCallbacks) {
+            if(IsChanged(*pPrevious, *pNext, callback.first)) {
+                callback.second(pPrevious->mSlots[callback.first], pNext->mSlots[callback.first]);
+            }
+        }
+    }
 
-private:
-    /// @brief Split a comma-separated string into multiple
-    void SplitCsvStr(String input, Vector<String> &output) {
-        int inputLength = input.length();
-        int start = 0;
-        for(int i = 0; i < inputLength; i++) {
-            if(input[i] == ',') {
-                int end = i;
-                int len = end - start;
-                if(len > 0) {
-                    String result = input.substr(start, len);
-                    output.push_back(result);
-                }
-                start = i+1;
+    /// @brief Merge mChange and mUnset into the current arguments, check them and publish them
+    ParseError applyChange() {
+        std::shared_ptr<const ArgParserResult> current = std::atomic_load(&this->mCurrent);
+        if(!current) {
+            throw std::logic_error("LiveArgs::parse must be called before LiveArgs::apply");
+        }
+        const ArgParser &parser = this->mParser;
+        ParseError error;
+        if(parser.mHasFinalArg) {
+            // It's matched as the last token, so keep it there
+            this->mChange.mTokens.push_back(current->mSlots[parser.getFinalArgSlot()].mValue);
+        }
+        if(!parser.matchPartial(this->mChange, error)) {
+            // Index the tokens given, not counting the program name added before them
+            if(error.mTokenIndex != ParseError::npos) {
+                error.mTokenIndex--;
             }
+            return error;
         }
-        {
-            int end = inputLength;
-            int len = end - start;
-            if(len > 0) {
-                String result = input.substr(start, len);
-                output.push_back(result);
+        // The command line that gives the merged arguments, as views of the change and the current arguments.
+        // Flags are given with their values, so they can be turned off. Those tokens are stored in flags
+        Vector<StringView> tokens(GetResource());
+        StringPool flags(GetResource());
+        String flag;
+        tokens.push_back(current->mTokens.empty() ? StringView() : current->mTokens[0]);
+        for(uint32_t slot = 0; slot < parser.mArgs.size(); slot++) {
+            // What the change gives wins over what it unsets
+            const ArgParserResult* source = this->mChange.mSeen[slot] ? &this->mChange : current.get();
+            if(!source->mSeen[slot] || (source == current.get() && this->mUnset[slot])) {
+                continue;
+            }
+            ArgDefPtr def = parser.mArgs[slot];
+            if(def->mIsFlag) {
+                flag.assign(def->mName).append(parser.mArgSplitChar.data(), parser.mArgSplitChar.length())
+                    .append(source->mSlots[slot].mValue.data(), source->mSlots[slot].mValue.length());
+                tokens.push_back(StringView(flags.store(flag), flag.length()));
+                continue;
             }
+            for(StringView value : source->getSlotValues(slot)) {
+                tokens.push_back(def->mName);
+                tokens.push_back(value);
+            }
+        }
+        if(parser.mPositionals != NULL) {
+            const ArgParserResult &source = !this->mChange.mPositionals.empty() || this->mUnsetPositionals
+                ? this->mChange : *current;
+            tokens.push_back("--");
+            tokens.insert(tokens.end(), source.mPositionals.begin(), source.mPositionals.end());
+        }
+        if(parser.mHasFinalArg) {
+            tokens.push_back(current->mSlots[parser.getFinalArgSlot()].mValue);
+        }
+        std::shared_ptr<ArgParserResult> next = std::make_shared<ArgParserResult>(GetResource());
+        next->mTokens.assign(tokens.begin(), tokens.end());
+        next->copyTokens();
+        if(!parser.parseTokens(*next, error, false, true)) {
+            // The tokens aren't the ones given, so don't point at any
+            error.mTokenIndex = ParseError::npos;
+            error.mPosition = 0;
+            this->mRejected = next;
+            return error;
         }
+        this->publish(current, next);
+        return error;
     }
 
+public:
     /**
-     * @brief Split an argument pair, if possible
-     * @param arg The input argument, e.g. '--myarg=true'
-     * @param key The output key string, e.g. '--myarg'
-     * @param val The output value string, e.g. 'true'
-     * @return True if the argument was split, false otherwise
+     * @param pParser Must be finalized, and outlive this
+     * @throw std::logic_error If the parser has subcommands, or arguments were added since finalize was last called
      */
-    bool SplitArg(String arg, String &key, String &val) {
-        String splitC = this->mArgSplitChar;
-        String::iterator result = std::find_first_of(arg.begin(), arg.end(), splitC.begin(), splitC.end());
-        if(result != arg.end()) {
-            int foundAt = std::distance(arg.begin(), result);
-            int foundLen = splitC.length();
-            int valStart = foundAt+foundLen;
-            key = arg.substr(0, foundAt);
-            val = arg.substr(valStart, arg.length() - valStart);
-            return true;
+    explicit LiveArgs(const ArgParser &pParser) : mParser(pParser), mChange(GetResource()) {
+        if(pParser.mIndexDirty) {
+            throw std::logic_error("ArgParser::finalize must be called after adding arguments, before parsing");
         }
-        return false;
+        if(!pParser.mSubcommands.empty()) {
+            throw std::logic_error("LiveArgs can't be used with subcommands");
+        }
+    }
+
+    /**
+     * @brief Parse a whole command line, replacing the current arguments. Calls the callbacks of those
+     * that changed, unless it's the first parse.
+     * @return The error, if it failed. It refers into this, until the next parse or apply. The current
+     *   arguments are kept if it failed
+     */
+    ParseError parse(int argc, char const* const* argv) {
+        std::lock_guard<std::mutex> lock(this->mMutex);
+        std::shared_ptr<const ArgParserResult> current = std::atomic_load(&this->mCurrent);
+        std::shared_ptr<ArgParserResult> next = std::make_shared<ArgParserResult>(GetResource());
+        next->setArgv(argc, argv, false);
+        ParseError error;
+        if((this->mParser.mCfgResponseFiles && !this->mParser.expandResponseFiles(*next, error))
+                || !this->mParser.parseTokens(*next, error, false)) {
+            this->mRejected = next;
+            return error;
+        }
+        this->publish(current, next);
+        return error;
+    }
+
+    /**
+     * @brief Apply a change: some arguments, which replace the current values of those arguments, and
+     * some to unset. A repeatable argument's values are all replaced. So are the positionals, if any are given
+     * @param pTokens The arguments, without a program name. e.g. {"--threads", "8", "--verbose=false"}
+     * @param pCount The number of them
+     * @param pUnset Names or aliases of the arguments to unset, or the positionals' name to remove them all.
+     *   Any also given in pTokens take the value given
+     * @param pUnsetCount The number of them
+     * @return The error, if the change or the merged arguments are invalid, e.g. a mandatory argument
+     *   was unset. It refers into this and pUnset, until the next parse or apply. Its token index is into
+     *   pTokens, or npos if the fault is in pUnset or only in the merge. The current arguments are kept if
+     *   it failed
+     * @throw std::logic_error If parse hasn't been called
+     */
+    ParseError apply(const StringView* pTokens, size_t pCount, const StringView* pUnset=NULL, size_t pUnsetCount=0) {
+        std::lock_guard<std::mutex> lock(this->mMutex);
+        const ArgParser &parser = this->mParser;
+        this->mUnset.assign(parser.mArgs.size(), false);
+        this->mUnsetPositionals = false;
+        for(size_t i = 0; i < pUnsetCount; i++) {
+            uint32_t slot = parser.getArgSlot(pUnset[i]);
+            if(slot != ArgIndex::npos) {
+                this->mUnset[slot] = true;
+            } else if(parser.mPositionals != NULL && pUnset[i] == parser.mPositionals->mName) {
+                this->mUnsetPositionals = true;
+            } else {
+                ParseError error;
+                error.mKind = ErrorKind::UnknownArgument;
+                error.mKey = pUnset[i];
+                parser.suggest(pUnset[i], error);
+                return error;
+            }
+        }
+        this->mChange.clear();
+        // matchTokens skips the first, the program's name
+        this->mChange.mTokens.push_back(StringView());
+        this->mChange.mTokens.insert(this->mChange.mTokens.end(), pTokens, pTokens + pCount);
+        this->mChange.copyTokens();
+        return this->applyChange();
+    }
+
+    /**
+     * @brief Apply a change given as one string, split like a shell would. e.g. "--name 'My Server'"
+     * See apply(const StringView*, size_t)
+     * @throw std::logic_error If parse hasn't been called
+     */
+    ParseError apply(StringView pLine) {
+        String scratch(pLine.length(), '\0');
+        char* out = &scratch[0];
+        Vector<StringView> tokens(GetResource());
+        ShellTokenizer tokenizer(pLine);
+        StringView token;
+        ShellTokenizer::Status status;
+        while((status = tokenizer.next(token, out)) == ShellTokenizer::Token) {
+            tokens.push_back(token);
+        }
+        if(status == ShellTokenizer::UnterminatedQuote) {
+            ParseError error;
+            error.mKind = ErrorKind::UnterminatedQuote;
+            error.mTokenIndex = tokens.size();
+            error.mPosition = tokenizer.position();
+            return error;
+        }
+        return this->apply(tokens.data(), tokens.size());
+    }
+
+    /**
+     * @brief Unset an argument, as a change of its own. See apply(const StringView*, size_t, const StringView*, size_t)
+     * @throw std::logic_error If parse hasn't been called
+     */
+    ParseError unset(StringView pName) {
+        return this->apply(NULL, 0, &pName, 1);
     }
 
+    /**
+     * @brief The current arguments. Lock-free, from any thread. Keep hold of the pointer to keep them
+     * consistent: a change publishes a new result, rather than changing this one.
+     * NULL before the first parse
+     */
+    std::shared_ptr<const ArgParserResult> get() const {
+        return std::atomic_load(&this->mCurrent);
+    }
+
+    /**
+     * @brief Be called when an argument's value is changed by parse or apply, on the thread that changed it,
+     * after the new values are published
+     * @param pName Name or alias of the argument
+     * @throw std::invalid_argument If there's no such argument
+     */
+    void onChange(StringView pName, ChangeCallback pCallback) {
+        uint32_t slot = this->mParser.getArgSlot(pName);
+        if(slot == ArgIndex::npos) {
+            throw std::invalid_argument("Can't watch unknown argument: " + pName.toString());
+        }
+        std::lock_guard<std::mutex> lock(this->mMutex);
+        this->mCallbacks.push_back(std::make_pair(slot, std::move(pCallback)));
+    }
 };
 
 };
@@ -0,0 +1,502 @@
+#include "cppargparser.hpp"
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+using namespace argparse;
+
+namespace {
+
+// Results and subcommand parsers point back at their parser, so it mustn't move out from under them
+static_assert(!std::is_move_constructible<ArgParser>::value && !std::is_move_assignable<ArgParser>::value,
+    "ArgParser must not be movable");
+
+/// Checks that failed. Any make the run fail
+size_t gFailures = 0;
+
+/// @brief Count and report a failed check
+void Check(bool pPassed, const char* pWhat) {
+    if(!pPassed) {
+        std::cerr << "Check failed: " << pWhat << std::endl;
+        gFailures++;
+    }
+}
+
+/// @brief Write a file for a test to read. The test removes it
+void WriteFile(const char* pPath, const char* pText) {
+    FILE* file = fopen(pPath, "wb");
+    if(file == NULL) {
+        Check(false, pPath);
+        return;
+    }
+    fputs(pText, file);
+    fclose(file);
+}
+
+template<size_t N>
+ParseError TryParse(const ArgParser &pParser, const char* (&pArgv)[N], ArgParserResult &pResult) {
+    return pParser.tryParse((int)N, pArgv, pResult);
+}
+
+/**
+ * @brief Each kind of error tryParse reports, with the token at fault
+ */
+void TestErrorKinds() {
+    ArgParser parser;
+    int threads = 0;
+    parser.addArg("--threads", "-t", "Number of threads", false, &threads);
+    parser.addFlag("--colour", "-c", "Enable colour");
+    parser.finalize();
+    ArgParserResult result;
+
+    const char* good[] = { "program", "-t", "4", "--colour" };
+    ParseError error = TryParse(parser, good, result);
+    Check(error.mKind == ErrorKind::None && threads == 4, "a good command line parses");
+    Check(result["--colour"].asBool() && result["--threads"].asInt() == 4, "its values are in the result");
+
+    const char* unknown[] = { "program", "--thraeds", "4" };
+    error = TryParse(parser, unknown, result);
+    Check(error.mKind == ErrorKind::UnknownArgument && error.mTokenIndex == 1, "an unknown argument is UnknownArgument");
+    Check(error.mSuggestionCount > 0 && error.mSuggestions[0] == "--threads", "a misspelt argument is suggested its name");
+
+    const char* missing[] = { "program", "--colour" };
+    error = TryParse(parser, missing, result);
+    Check(error.mKind == ErrorKind::MissingArgument && error.mKey == "--threads", "a mandatory argument left out is MissingArgument");
+
+    const char* noValue[] = { "program", "--threads" };
+    error = TryParse(parser, noValue, result);
+    Check(error.mKind == ErrorKind::MissingValue && error.mKey == "--threads", "an argument without its value is MissingValue");
+
+    const char* badValue[] = { "program", "--threads", "many" };
+    error = TryParse(parser, badValue, result);
+    Check(error.mKind == ErrorKind::InvalidValue && error.mConvertError == ConvertError::Invalid && error.mTokenIndex == 2,
+        "a value the bound variable can't take is InvalidValue");
+}
+
+/**
+ * @brief Bound variables are only written by a parse that succeeds, each occurrence in order
+ */
+void TestBindings() {
+    ArgParser parser;
+    int threads = 1;
+    String output = "default";
+    bool verbose = true;
+    std::vector<int> levels;
+    parser.addArg("--threads", "-t", "Number of threads", &threads);
+    parser.addArg("--output", "-o", "The output file", &output);
+    parser.addFlag("--verbose", "-v", "Print more", &verbose);
+    parser.addRepeatableArg("--level", "-l", "A level");
+    parser.addArg("--mode", "-m", "How to run", false);
+    parser.bind("--level", &levels);
+    parser.finalize();
+    ArgParserResult result;
+
+    const char* laterUnknown[] = { "program", "-t", "8", "-o", "out", "-v", "-l", "1", "--unknown" };
+    Check(TryParse(parser, laterUnknown, result).mKind == ErrorKind::UnknownArgument, "an unknown argument fails the parse");
+    const char* laterMissing[] = { "program", "-t", "8", "-l", "1" };
+    Check(TryParse(parser, laterMissing, result).mKind == ErrorKind::MissingArgument, "a missing argument fails the parse");
+    const char* laterInvalid[] = { "program", "-t", "8", "-l", "1", "-l", "x", "-m", "fast" };
+    Check(TryParse(parser, laterInvalid, result).mKind == ErrorKind::InvalidValue, "a value that doesn't convert fails the parse");
+    Check(threads == 1 && output == "default" && verbose && levels.empty(), "a failed parse leaves the variables as they were");
+
+    const char* good[] = { "program", "-t", "8", "-t", "9", "-l", "3", "-m", "fast", "--level=1", "-o", "out" };
+    Check(!TryParse(parser, good, result), "a good command line parses");
+    Check(threads == 8 && output == "out", "the first occurrence is stored");
+    Check(!verbose, "a missing flag is stored as false");
+    Check(levels.size() == 2 && levels[0] == 3 && levels[1] == 1, "a vector gets every occurrence, in order");
+}
+
+/**
+ * @brief The conversions of a value: numbers, sizes, bools and lists
+ */
+void TestConversions() {
+    ArgPair pair;
+    int number = 0;
+    pair.mValue = "-42";
+    Check(pair.to(number) == ConvertError::None && number == -42, "to converts a signed int");
+    int8_t small = 0;
+    pair.mValue = "300";
+    Check(pair.to(small) == ConvertError::OutOfRange, "to reports a value too big for the type");
+    pair.mValue = "12abc";
+    Check(pair.to(number) == ConvertError::Trailing, "to reports characters after the number");
+    pair.mValue = "";
+    Check(pair.to(number) == ConvertError::Empty && pair.asInt(7) == 7, "an empty value takes the default");
+
+    double real = 0;
+    pair.mValue = "0.25";
+    Check(pair.to(real) == ConvertError::None && real == 0.25, "to converts a double");
+    pair.mValue = "-1.5e3";
+    Check(pair.to(real) == ConvertError::None && real == -1500, "to converts a double with an exponent");
+    pair.mValue = "1e400";
+    Check(pair.to(real) == ConvertError::OutOfRange, "to reports a double out of range");
+    String longValue(200, '1');
+    pair.mValue = longValue;
+    Check(pair.to(real) == ConvertError::Invalid, "a double too long to convert is Invalid");
+
+    // Suffixes are one of KMGTP, in either case, and nothing may follow them
+    uint64_t size = 0;
+    pair.mValue = "2k";
+    Check(pair.toSize(size) == ConvertError::None && size == 2048, "toSize(\"2k\") is 2048");
+    pair.mValue = "1P";
+    Check(pair.toSize(size) == ConvertError::None && size == (1ull << 50), "toSize(\"1P\") is 1<<50");
+    pair.mValue = "1 ";
+    Check(pair.toSize(size) == ConvertError::Trailing, "toSize(\"1 \") has trailing characters");
+    pair.mValue = "1K ";
+    Check(pair.toSize(size) == ConvertError::Trailing, "toSize(\"1K \") has trailing characters");
+    pair.mValue = "1X";
+    Check(pair.toSize(size) == ConvertError::Trailing, "toSize(\"1X\") has an unknown suffix");
+    pair.mValue = "1@";
+    Check(pair.toSize(size) == ConvertError::Trailing, "toSize(\"1@\") has an unknown suffix");
+    pair.mValue = StringView("1\0", 2);
+    Check(pair.toSize(size) == ConvertError::Trailing, "toSize(\"1\\0\") has trailing characters");
+    pair.mValue = "16E";
+    Check(pair.toSize(size) == ConvertError::Trailing, "toSize(\"16E\") has an unknown suffix");
+
+    pair.mValue = "yes";
+    Check(pair.asBool(), "asBool takes yes");
+    pair.mValue = "1,5,9";
+    Vector<int> list;
+    Check(pair.toList(list) == ConvertError::None && list.size() == 3 && list[2] == 9, "toList converts every element");
+    pair.mValue = "1,x,9";
+    size_t errorIndex = 0;
+    Check(pair.toList(list, ',', &errorIndex) == ConvertError::Invalid && errorIndex == 1, "toList names the element at fault");
+}
+
+/**
+ * @brief A repeatable argument keeps every occurrence, in order, however it's given
+ */
+void TestRepeatable() {
+    ArgParser parser;
+    parser.addRepeatableArg("--input", "-i", "An input file");
+    parser.addArg("--output", "-o", "The output file");
+    parser.finalize();
+    ArgParserResult result;
+
+    const char* argv[] = { "program", "--input", "a", "-o", "out", "-i", "b", "--input=c" };
+    Check(!TryParse(parser, argv, result), "repeated arguments parse");
+    ArgValues inputs = result.getAll("--input");
+    Check(inputs.size() == 3 && inputs[0] == "a" && inputs[1] == "b" && inputs[2] == "c", "getAll has every value, in order");
+    Check(result["-i"].mValue == "a", "operator[] has the first value");
+    Check(result.getAll("--output").size() == 1, "getAll of a single argument has its value");
+
+    const char* none[] = { "program" };
+    Check(!TryParse(parser, none, result) && result.getAll("--input").empty(), "getAll of a missing argument is empty");
+}
+
+/**
+ * @brief Response files, including each other, and the errors when they can't be read or include themselves
+ */
+void TestResponseFiles() {
+    ArgParser parser;
+    parser.addArg("--threads", "-t", "Number of threads");
+    parser.addFlag("--colour", "-c", "Enable colour");
+    parser.addRepeatableArg("--input", "-i", "An input file");
+    parser.setResponseFiles(true);
+    parser.finalize();
+    ArgParserResult result;
+
+    WriteFile("cpp_arg_parser_tests_outer.rsp", "--threads 4 --input 'first file' @cpp_arg_parser_tests_inner.rsp");
+    WriteFile("cpp_arg_parser_tests_inner.rsp", "--colour --input second");
+    WriteFile("cpp_arg_parser_tests_cycle.rsp", "--colour @cpp_arg_parser_tests_cycle.rsp");
+
+    const char* argv[] = { "program", "@cpp_arg_parser_tests_outer.rsp", "--input", "third" };
+    Check(!TryParse(parser, argv, result), "a command line with response files parses");
+    Check(result["--threads"].asInt() == 4 && result["--colour"].asBool(), "the response files' arguments are read");
+    ArgValues inputs = result.getAll("--input");
+    Check(inputs.size() == 3 && inputs[0] == "first file" && inputs[1] == "second" && inputs[2] == "third",
+        "response files are expanded in place, in order");
+
+    const char* cycle[] = { "program", "@cpp_arg_parser_tests_cycle.rsp" };
+    ParseError error = TryParse(parser, cycle, result);
+    Check(error.mKind == ErrorKind::ResponseFileCycle && error.mTokenIndex == 1, "a response file including itself is ResponseFileCycle");
+
+    const char* missing[] = { "program", "@cpp_arg_parser_tests_missing.rsp" };
+    error = TryParse(parser, missing, result);
+    Check(error.mKind == ErrorKind::ResponseFile && error.mKey == "cpp_arg_parser_tests_missing.rsp", "a missing response file is ResponseFile");
+
+    remove("cpp_arg_parser_tests_outer.rsp");
+    remove("cpp_arg_parser_tests_inner.rsp");
+    remove("cpp_arg_parser_tests_cycle.rsp");
+}
+
+/**
+ * @brief The command line overrides the environment, which overrides config files
+ */
+void TestSourcePrecedence() {
+    const char* path = "cpp_arg_parser_tests.ini";
+    WriteFile(path,
+        "# Comment\n"
+        "threads = 1\n"
+        "--level = 'info'\n"
+        "[other]\n"
+        "level = debug\n");
+    ArgParser parser;
+    parser.addArg("--threads", "-t", "Number of threads");
+    parser.addArg("--level", "-l", "Log level");
+    parser.addArg("--output", "-o", "The output file");
+    parser.finalize();
+    parser.loadConfigFile(path);
+    ArgParserResult result;
+
+    const char* none[] = { "program" };
+    Check(!TryParse(parser, none, result), "a command line taking values from a config file parses");
+    Check(result["--threads"].mValue == "1" && result["--level"].mValue == "info", "values come from the config file");
+    Check(result["--output"].mValue.empty(), "arguments in no source are missing");
+
+#ifdef CPP_ARG_PARSER_HAS_MMAP
+    parser.setEnvVar("--threads", "CPP_ARG_PARSER_TESTS_THREADS");
+    setenv("CPP_ARG_PARSER_TESTS_THREADS", "2", 1);
+    parser.loadEnvironment();
+    Check(!TryParse(parser, none, result) && result["--threads"].mValue == "2", "the environment overrides a config file");
+    unsetenv("CPP_ARG_PARSER_TESTS_THREADS");
+#endif
+
+    const char* given[] = { "program", "--threads", "3" };
+    Check(!TryParse(parser, given, result) && result["--threads"].mValue == "3", "the command line overrides the other sources");
+    Check(result["--level"].mValue == "info", "the others still fill in what it doesn't give");
+
+    parser.clearSources();
+    Check(!TryParse(parser, none, result) && result["--threads"].mValue.empty(), "clearSources forgets the values");
+    remove(path);
+}
+
+/**
+ * @brief A repeatable argument keeps every value a config file gives it, and a later file replaces them
+ */
+void TestRepeatableConfig() {
+    const char* first = "cpp_arg_parser_tests_first.ini";
+    const char* second = "cpp_arg_parser_tests_second.ini";
+    WriteFile(first,
+        "input = a\n"
+        "threads = 1\n"
+        "--input = b\n"
+        "threads = 2\n"
+        "-i = c\n");
+    WriteFile(second,
+        "level = debug\n"
+        "input = d\n");
+    ArgParser parser;
+    parser.addRepeatableArg("--input", "-i", "An input file");
+    parser.addArg("--threads", "-t", "Number of threads");
+    parser.addArg("--level", "-l", "Log level");
+    parser.finalize();
+    ArgParserResult result;
+    const char* none[] = { "program" };
+
+    parser.loadConfigFile(first);
+    Check(!TryParse(parser, none, result), "a command line taking repeated values from a config file parses");
+    ArgValues inputs = result.getAll("--input");
+    Check(inputs.size() == 3 && inputs[0] == "a" && inputs[1] == "b" && inputs[2] == "c", "getAll has every config value, in order");
+    Check(result["--input"].mValue == "a" && result["--threads"].mValue == "2", "the first repeated value, and the last single one, win");
+
+    parser.loadConfigFile(second);
+    Check(!TryParse(parser, none, result), "a command line taking values from two config files parses");
+    inputs = result.getAll("--input");
+    Check(inputs.size() == 1 && inputs[0] == "d", "a later file replaces all of the earlier file's values");
+    Check(result["--threads"].mValue == "2" && result["--level"].mValue == "debug", "values the later file doesn't give are kept");
+
+    const char* given[] = { "program", "-i", "e" };
+    inputs = TryParse(parser, given, result) ? ArgValues() : result.getAll("--input");
+    Check(inputs.size() == 1 && inputs[0] == "e", "the command line replaces the config file's values");
+    remove(first);
+    remove(second);
+}
+
+/**
+ * @brief A snapshot read back, from a parser allocating from an Arena, and refused by a parser with
+ * different arguments
+ */
+void TestSnapshot() {
+    Arena arena;
+    ArgParser parser(&arena);
+    parser.addArg("--threads", "-t", "Number of threads");
+    parser.addArg("--output", "-o", "The output file");
+    parser.addRepeatableArg("--input", "-i", "An input file");
+    parser.finalize();
+    const char* argv[] = { "program", "--threads=4", "-i", "a", "-i", "b" };
+    Check(parser.parse(6, argv), "parse before snapshot");
+
+    arena.allocate(1, 1); // Leave the arena unaligned, as odd-length strings would
+    SnapshotBuffer snapshot = parser.snapshot();
+    ArgSnapshot reader(parser);
+    try {
+        reader.attach(snapshot.data(), snapshot.size());
+        Check(reader["--threads"].mValue == "4", "snapshot value read back");
+        Check(reader["--output"].mValue.empty(), "snapshot unset value read back");
+        ArgSnapshot::Values inputs = reader.getAll("--input");
+        Check(inputs.size() == 2 && inputs[0] == "a" && inputs[1] == "b", "snapshot repeated values read back");
+    } catch(const std::exception &e) {
+        Check(false, e.what());
+    }
+
+    ArgParser other;
+    other.addArg("--threads", "-t", "Number of threads");
+    other.addArg("--output", "-o", "The output file");
+    other.finalize();
+    Check(other.getFingerprint() != parser.getFingerprint(), "parsers with different arguments have different fingerprints");
+    ArgSnapshot otherReader(other);
+    bool isRefused = false;
+    try {
+        otherReader.attach(snapshot.data(), snapshot.size());
+    } catch(const std::runtime_error&) {
+        isRefused = true;
+    }
+    Check(isRefused, "a snapshot from a parser with different arguments is refused");
+}
+
+/**
+ * @brief Choices, ranges and patterns on values
+ */
+void TestConstraints() {
+    ArgParser parser;
+    parser.addArg("--mode", "-m", "How to run");
+    parser.addArg("--ratio", "-r", "A fraction");
+    parser.addArg("--host", "", "A server");
+    parser.setChoices("--mode", "fast,slow,careful");
+    parser.setRange("--ratio", 0, 1);
+    parser.setPattern("--host", "srv-[0-9]*");
+    parser.finalize();
+    ArgParserResult result;
+
+    const char* good[] = { "program", "--mode", "slow", "--ratio", "0.5", "--host", "srv-12" };
+    Check(!TryParse(parser, good, result), "values meeting the constraints parse");
+    Check(result["--mode"].mChoice == 1, "the choice given is indexed");
+
+    const char* badChoice[] = { "program", "--mode", "medium" };
+    ParseError error = TryParse(parser, badChoice, result);
+    Check(error.mKind == ErrorKind::InvalidValue && error.mValue == "medium" && error.mTokenIndex == 2, "a value not among the choices is InvalidValue");
+
+    const char* outOfRange[] = { "program", "--ratio", "1.5" };
+    error = TryParse(parser, outOfRange, result);
+    Check(error.mKind == ErrorKind::InvalidValue && error.mConvertError == ConvertError::OutOfRange, "a value outside the range is OutOfRange");
+
+    const char* notANumber[] = { "program", "--ratio=half" };
+    error = TryParse(parser, notANumber, result);
+    Check(error.mKind == ErrorKind::InvalidValue && error.mConvertError == ConvertError::Invalid, "a range's value must be a number");
+
+    const char* badPattern[] = { "program", "--host", "db-1" };
+    error = TryParse(parser, badPattern, result);
+    Check(error.mKind == ErrorKind::InvalidValue && error.mKey == "--host", "a value not matching the pattern is InvalidValue");
+}
+
+/**
+ * @brief Completing option names and values, and answering a completion request instead of parsing
+ */
+void TestCompletion() {
+    ArgParser parser;
+    parser.addArg("--threads", "-t", "Number of threads");
+    parser.addArg("--level", "-l", "Log level");
+    parser.addFlag("--colour", "-c", "Enable colour");
+    parser.setCompletions("--level", "debug,info,warn");
+    parser.setCompletion(true);
+
+    Vector<StringView> candidates;
+    StringView names[] = { "program", "--colour", "--" };
+    StringView prefix = parser.complete(names, 3, 2, candidates);
+    Check(prefix.empty() && candidates.size() == 3 && candidates[0] == "--colour" && candidates[1] == "--level"
+        && candidates[2] == "--threads", "option names complete, sorted");
+
+    candidates.clear();
+    StringView values[] = { "program", "--level", "" };
+    parser.complete(values, 3, 2, candidates);
+    Check(candidates.size() == 3 && candidates[0] == "debug", "an option's value completes to its values");
+
+    candidates.clear();
+    StringView joined[] = { "program", "--level=i" };
+    prefix = parser.complete(joined, 2, 1, candidates);
+    Check(prefix == "--level=" && candidates.size() == 1 && candidates[0] == "info", "a joined value completes after its option");
+
+    candidates.clear();
+    StringView afterFlag[] = { "program", "--colour", "--th" };
+    parser.complete(afterFlag, 3, 2, candidates);
+    Check(candidates.size() == 1 && candidates[0] == "--threads", "a flag takes no value, so the next word is an option");
+
+    // Answered without finalizing. The candidate is printed to stdout
+    ArgParserResult result;
+    const char* request[] = { "program", "--__complete", "1", "program", "--thr" };
+    ParseError error = TryParse(parser, request, result);
+    Check(error.mKind == ErrorKind::Completed && result.mCompleted, "a completion request is answered instead of parsed");
+}
+
+/**
+ * @brief Changing arguments while running: merging changes, unsetting, and rejecting bad changes
+ */
+void TestLiveArgs() {
+    ArgParser parser;
+    parser.addArg("--threads", "-t", "Number of threads", false);
+    parser.addArg("--mode", "-m", "How to run");
+    parser.addFlag("--verbose", "-v", "Print more");
+    parser.finalize();
+
+    LiveArgs args(parser);
+    const char* argv[] = { "program", "--threads", "2", "--verbose", "--mode", "fast" };
+    Check(!args.parse(6, argv), "the first parse succeeds");
+    size_t threadChanges = 0;
+    args.onChange("--threads", [&threadChanges](ArgPair, ArgPair pNew) {
+        threadChanges++;
+        Check(pNew.mValue == "8", "the callback is given the new value");
+    });
+
+    std::shared_ptr<const ArgParserResult> before = args.get();
+    Check(!args.apply("--threads 8 --verbose=false"), "a change applies");
+    std::shared_ptr<const ArgParserResult> after = args.get();
+    Check((*after)["--threads"].mValue == "8" && !(*after)["--verbose"].asBool(), "the change's values are published");
+    Check((*after)["--mode"].mValue == "fast", "arguments the change doesn't give are kept");
+    Check((*before)["--threads"].mValue == "2", "results already published aren't changed");
+    Check(threadChanges == 1, "the callback is called for a change");
+
+    Check(!args.unset("--mode") && (*args.get())["--mode"].mValue.empty(), "an unset argument goes back to its default");
+
+    ParseError error = args.unset("--threads");
+    Check(error.mKind == ErrorKind::MissingArgument && (*args.get())["--threads"].mValue == "8",
+        "unsetting a mandatory argument is refused, keeping the current arguments");
+    error = args.apply("--thraeds 4");
+    Check(error.mKind == ErrorKind::UnknownArgument && error.mTokenIndex == 0, "an unknown argument in a change is refused");
+    Check(threadChanges == 1, "refused changes call no callbacks");
+}
+
+/**
+ * @brief Changes to the arguments of a parser allocating from an Arena don't grow it. They outlive
+ * any arena a program would release
+ */
+void TestLiveArgsMemory() {
+    Arena arena;
+    ArgParser parser(&arena);
+    parser.addArg("--threads", "-t", "Number of threads");
+    parser.addFlag("--verbose", "-v", "Print more");
+    parser.finalize();
+    LiveArgs args(parser);
+    const char* argv[] = { "program", "--threads", "2" };
+    Check(!args.parse(3, argv), "the first parse succeeds");
+    size_t reserved = arena.reserved();
+    for(int i = 0; i < 1000; i++) {
+        args.apply(i % 2 == 0 ? "--threads 8 --verbose" : "--threads 4 --verbose=false");
+    }
+    Check(arena.reserved() == reserved, "applying changes takes nothing from the parser's arena");
+}
+
+}
+
+/**
+ * @brief Entry point for the tests. Prints each failed check, and fails if there were any
+ */
+int main() {
+    TestErrorKinds();
+    TestBindings();
+    TestConversions();
+    TestRepeatable();
+    TestResponseFiles();
+    TestSourcePrecedence();
+    TestRepeatableConfig();
+    TestSnapshot();
+    TestConstraints();
+    TestCompletion();
+    TestLiveArgs();
+    TestLiveArgsMemory();
+    if(gFailures > 0) {
+        std::cerr << gFailures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}